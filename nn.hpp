@@ -0,0 +1,272 @@
+#ifndef __NN_HPP__
+#define __NN_HPP__
+
+
+#include <algorithm>	// std::copy
+#include <array>	// std::array
+#include <cmath>	// std::exp
+#include <initializer_list>	// std::initializer_list
+#include <stdexcept>	// std::invalid_argument, std::runtime_error
+#include <string>	// std::string, std::to_string
+#include <utility>	// std::exchange, std::swap, std::integer_sequence
+
+// The C headers use `this` for parameter names, which is a keyword in C++, so it's renamed while they're included.
+// Their standard headers are included first, so the rename only touches the library's own declarations.
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define this this_
+extern "C" {
+#include "nn_Matrix.h"
+#include "nn_SparseMatrix.h"
+#include "nn_Network.h"
+}
+#undef this
+
+// Header only C++ wrappers, the library's .c files are still compiled as C and linked in.
+// - nn::Matrix and nn::Network own an nn_Matrix or nn_Network and free it when they go out of scope. They can be
+//   moved but not copied, and get() gives the C struct for anything that isn't wrapped.
+// - nn::FixedNetwork<2, 3, 1> has its layout fixed at compile time, with its weights and activations in std::arrays
+//   inside the object. Inference doesn't allocate or parse anything, and every loop has a constant size, so the
+//   compiler can unroll and vectorise each layer. The weights are in the same order as nn_Network's, so they can be
+//   copied to and from an nn::Network, or read and written in the usual file format.
+
+namespace nn {
+
+class Matrix {
+public:
+	Matrix(int rows, int columns) : matrix(nn_Matrix_alloc(rows, columns)) {}
+
+	// values are row by row, like nn_Matrix_allocWithValues
+	Matrix(int rows, int columns, std::initializer_list<double> values) : Matrix(rows, columns) {
+		if ((int)values.size() != rows * columns) {
+			throw std::invalid_argument("Matrix needs " + std::to_string(rows * columns) + " values");
+		}
+		std::copy(values.begin(), values.end(), matrix->data);
+	}
+
+	// takes ownership of `matrix`
+	explicit Matrix(nn_Matrix *matrix) : matrix(matrix) {}
+
+	~Matrix() {
+		if (matrix != nullptr) {
+			nn_Matrix_free(matrix);
+		}
+	}
+
+	Matrix(const Matrix &) = delete;
+	Matrix &operator=(const Matrix &) = delete;
+	Matrix(Matrix &&other) noexcept : matrix(std::exchange(other.matrix, nullptr)) {}
+	Matrix &operator=(Matrix &&other) noexcept {
+		std::swap(matrix, other.matrix);
+		return *this;
+	}
+
+	int rows() const { return matrix->rows; }
+	int columns() const { return matrix->columns; }
+	double *data() { return matrix->data; }
+	const double *data() const { return matrix->data; }
+	double &operator()(int row, int column) { return matrix->data[matrix->columns * row + column]; }
+	double operator()(int row, int column) const { return matrix->data[matrix->columns * row + column]; }
+
+	nn_Matrix *get() const { return matrix; }
+	// gives up ownership, the caller has to nn_Matrix_free it
+	nn_Matrix *release() { return std::exchange(matrix, nullptr); }
+
+private:
+	nn_Matrix *matrix;
+};
+
+class Network {
+public:
+	// e.g. "2, 3, 1", see nn_Network_alloc
+	explicit Network(const std::string &layout) : network(nn_Network_alloc(const_cast<char *>(layout.c_str()))) {}
+
+	// takes ownership of `network`
+	explicit Network(nn_Network *network) : network(network) {}
+
+	static Network fromFile(const std::string &filename) {
+		nn_Network *network = nn_Network_allocFromFile(const_cast<char *>(filename.c_str()));
+		if (network == nullptr) {
+			throw std::runtime_error("Error reading network from '" + filename + "'");
+		}
+		return Network(network);
+	}
+
+	~Network() {
+		if (network != nullptr) {
+			nn_Network_free(network);
+		}
+	}
+
+	Network(const Network &) = delete;
+	Network &operator=(const Network &) = delete;
+	Network(Network &&other) noexcept : network(std::exchange(other.network, nullptr)) {}
+	Network &operator=(Network &&other) noexcept {
+		std::swap(network, other.network);
+		return *this;
+	}
+
+	int numberOfLayers() const { return network->numberOfLayers; }
+	int numberOfNodesAtLayerIndex(int layerIndex) const { return nn_Network_numberOfNodesAtLayerIndex(network, layerIndex); }
+
+	// doesn't change the network, so it can be called from many threads at once
+	Matrix inference(const Matrix &inputs) const { return Matrix(nn_Network_allocInference(network, inputs.get())); }
+
+	// `trainingDataInputs` has to stay alive until the next call, because the network keeps a pointer to it
+	double train(const Matrix &trainingDataInputs, const Matrix &trainingDataOutputs, double trainingIncrement) {
+		return nn_Network_train(network, trainingDataInputs.get(), trainingDataOutputs.get(), trainingIncrement);
+	}
+
+	void randomiseWeightsBetweenMinAndMax(double min, double max) {
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, min, max);
+	}
+	void randomiseWeightsBetweenMinAndMax(double min, double max, unsigned int seed) {
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, min, max, seed);
+	}
+
+	// returns 0, or one of the NN_ERROR_WRITE_* codes
+	int writeToFile(const std::string &filename, int precision = NN_PRECISION_DOUBLE) const {
+		return nn_Network_writeToFileWithPrecision(network, const_cast<char *>(filename.c_str()), precision);
+	}
+
+	nn_Network *get() const { return network; }
+	// gives up ownership, the caller has to nn_Network_free it
+	nn_Network *release() { return std::exchange(network, nullptr); }
+
+private:
+	nn_Network *network;
+};
+
+// e.g. nn::FixedNetwork<2, 3, 1> is the same as nn_Network_alloc("2, 3, 1"). The weights start at 0.
+// It's a plain value, with no pointers, so it can be copied, and be a member of another struct. Each object
+// keeps the activations of its last inference, so only do one inference at a time with each object.
+template <int... LayerSizes>
+class FixedNetwork {
+	static_assert(sizeof...(LayerSizes) >= 2, "FixedNetwork needs at least an input layer and an output layer");
+
+public:
+	static constexpr int numberOfLayers = sizeof...(LayerSizes);
+	static constexpr std::array<int, sizeof...(LayerSizes)> layerSizes = { LayerSizes... };
+	static constexpr int numberOfInputs = layerSizes[0];
+	static constexpr int numberOfOutputs = layerSizes[numberOfLayers - 1];
+
+	static FixedNetwork fromFile(const std::string &filename) {
+		FixedNetwork fixedNetwork;
+		fixedNetwork.copyWeightsFromNetwork(Network::fromFile(filename));
+		return fixedNetwork;
+	}
+
+	std::array<double, numberOfOutputs> inference(const std::array<double, numberOfInputs> &inputs) {
+		std::array<double, numberOfOutputs> outputs;
+		inference(inputs.data(), outputs.data());
+		return outputs;
+	}
+
+	void inference(const double *inputs, double *outputs) {
+		std::copy(inputs, inputs + numberOfInputs, activations.data());
+		fillActivations(std::make_integer_sequence<int, numberOfLayers - 1>());
+		const double *outputActivations = &activations[activationsOffset(numberOfLayers - 1)];
+		std::copy(outputActivations, outputActivations + numberOfOutputs, outputs);
+	}
+
+	// same layout as nn_Network's layerWeights[layer]->data, i.e. layerSizes[layer - 1] rows of layerSizes[layer]
+	double *weightsAtLayer(int layer) { return &weights[weightsOffset(layer)]; }
+	const double *weightsAtLayer(int layer) const { return &weights[weightsOffset(layer)]; }
+
+	// `network` must have the same layout
+	void copyWeightsFromNetwork(const Network &network) {
+		checkLayout(network);
+		for (int l = 1; l < numberOfLayers; l++) {
+			const double *layerWeights = network.get()->layerWeights[l]->data;
+			std::copy(layerWeights, layerWeights + layerSizes[l - 1] * layerSizes[l], weightsAtLayer(l));
+		}
+	}
+
+	// `network` must have the same layout
+	void copyWeightsToNetwork(Network &network) const {
+		checkLayout(network);
+		for (int l = 1; l < numberOfLayers; l++) {
+			std::copy(weightsAtLayer(l), weightsAtLayer(l) + layerSizes[l - 1] * layerSizes[l], network.get()->layerWeights[l]->data);
+		}
+	}
+
+	// e.g. "2, 3, 1", for nn::Network or nn_Network_alloc
+	static std::string layout() {
+		std::string layout = std::to_string(layerSizes[0]);
+		for (int l = 1; l < numberOfLayers; l++) {
+			layout += ", " + std::to_string(layerSizes[l]);
+		}
+		return layout;
+	}
+
+	// returns 0, or one of the NN_ERROR_WRITE_* codes
+	int writeToFile(const std::string &filename, int precision = NN_PRECISION_DOUBLE) const {
+		Network network(layout());
+		copyWeightsToNetwork(network);
+		return network.writeToFile(filename, precision);
+	}
+
+private:
+	// where each layer starts in `weights` and `activations`
+	static constexpr int weightsOffset(int layer) {
+		int offset = 0;
+		for (int l = 1; l < layer; l++) {
+			offset += layerSizes[l - 1] * layerSizes[l];
+		}
+		return offset;
+	}
+	static constexpr int activationsOffset(int layer) {
+		int offset = 0;
+		for (int l = 0; l < layer; l++) {
+			offset += layerSizes[l];
+		}
+		return offset;
+	}
+
+	template <int... Layers>
+	void fillActivations(std::integer_sequence<int, Layers...>) {
+		(fillActivationsAtLayer<Layers + 1>(), ...);
+	}
+
+	// Adds up each row of weights times its previous activation, so the inner loop runs along a row of weights,
+	// which is contiguous. Each weighted sum is still added up in the same order as nn_Network's.
+	template <int Layer>
+	void fillActivationsAtLayer() {
+		constexpr int rows = layerSizes[Layer - 1];
+		constexpr int columns = layerSizes[Layer];
+		const double *previousActivations = &activations[activationsOffset(Layer - 1)];
+		const double *layerWeights = &weights[weightsOffset(Layer)];
+		double *weightedSums = &activations[activationsOffset(Layer)];
+		for (int column = 0; column < columns; column++) {
+			weightedSums[column] = 0.0;
+		}
+		for (int row = 0; row < rows; row++) {
+			for (int column = 0; column < columns; column++) {
+				weightedSums[column] += previousActivations[row] * layerWeights[row * columns + column];
+			}
+		}
+		// sigmoid, the same as nn_Network's
+		for (int column = 0; column < columns; column++) {
+			weightedSums[column] = 1 / (1 + std::exp(0 - weightedSums[column]));
+		}
+	}
+
+	static void checkLayout(const Network &network) {
+		bool isSameLayout = network.numberOfLayers() == numberOfLayers;
+		for (int l = 0; isSameLayout && l < numberOfLayers; l++) {
+			isSameLayout = network.numberOfNodesAtLayerIndex(l) == layerSizes[l];
+		}
+		if (!isSameLayout) {
+			throw std::invalid_argument("Network doesn't have the layout " + layout());
+		}
+	}
+
+	std::array<double, weightsOffset(numberOfLayers)> weights {};
+	std::array<double, activationsOffset(numberOfLayers)> activations {};
+};
+
+}
+
+
+#endif
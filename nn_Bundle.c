@@ -0,0 +1,261 @@
+#include <stdlib.h>	// malloc, free, atoi
+#include <string.h>	// strlen, strcpy, strtok
+
+#include "nn_Bundle.h"
+
+// Trains many small networks at once. A network like "2, 3, 1" is far too small to fill the vector registers,
+// but with the weights interleaved, the innermost loop of every step goes across the networks, over values that
+// are next to each other in memory, so the compiler can vectorise it with each network in its own lane.
+// Each network gets its own training increment and random seed, so it can be used for hyperparameter sweeps.
+
+// 'private' functions
+void nn_Bundle__allocActivations(nn_Bundle *this, int numberOfExamples);
+void nn_Bundle__freeActivations(nn_Bundle *this);
+void nn_Bundle__inference(nn_Bundle *this, nn_Matrix *inputs);
+void nn_Bundle__fillActivationsAtLayer(nn_Bundle *this, int layer);
+
+nn_Bundle *nn_Bundle_alloc(char *layout, int numberOfNetworks) {
+	nn_Bundle *this = malloc(sizeof(nn_Bundle));
+	this->numberOfNetworks = numberOfNetworks;
+	this->layerActivations = NULL;
+	this->numberOfExamples = 0;
+
+	this->numberOfLayers = 1;	// starts at 1 because there will be one more layer than there are commas
+	for (int i = 0; layout[i] != '\0'; i++) {
+		if (layout[i] == ',') {
+			this->numberOfLayers++;
+		}
+	}
+
+	// Make a copy of `layout` string because strtok doesn't work on string literals
+	char *layoutCopy = malloc(sizeof(char) * (strlen(layout) + 1));
+	strcpy(layoutCopy, layout);
+	this->layerSizes = malloc(sizeof(int) * this->numberOfLayers);
+	char *singleLayerSizeString = strtok(layoutCopy, ",");
+	for (int l = 0; l < this->numberOfLayers; l++) {
+		this->layerSizes[l] = atoi(singleLayerSizeString);
+		singleLayerSizeString = strtok(NULL, ",");
+	}
+	free(layoutCopy);
+
+	this->layerWeights = malloc(sizeof(double *) * this->numberOfLayers);
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		this->layerWeights[l] = calloc((size_t)this->layerSizes[l - 1] * this->layerSizes[l] * numberOfNetworks, sizeof(double));
+	}
+
+	return this;
+}
+
+void nn_Bundle_free(nn_Bundle *this) {
+	nn_Bundle__freeActivations(this);
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		free(this->layerWeights[l]);
+	}
+	free(this->layerWeights);
+	free(this->layerSizes);
+	free(this);
+}
+
+// Trains every network for one step on the same examples, each with its own value from `trainingIncrements`.
+// If `costs` isn't NULL it's filled with the average cost of each network, like nn_Network_train returns.
+void nn_Bundle_train(nn_Bundle *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double *trainingIncrements, double *costs) {
+	int numberOfNetworks = this->numberOfNetworks;
+	int numberOfExamples = trainingDataInputs->rows;
+	nn_Bundle__inference(this, trainingDataInputs);
+
+	// Deltas for the output layer, and the total cost of each network
+	int numberOfOutputs = this->layerSizes[this->numberOfLayers - 1];
+	double *outputs = this->layerActivations[this->numberOfLayers - 1];
+	double *deltas = malloc(sizeof(double) * numberOfExamples * numberOfOutputs * numberOfNetworks);
+	double *totalCosts = calloc(numberOfNetworks, sizeof(double));
+	for (int e = 0; e < numberOfExamples; e++) {
+		for (int j = 0; j < numberOfOutputs; j++) {
+			double desiredOutput = nn_Matrix_get(trainingDataOutputs, e, j);
+			double *output = outputs + (e * numberOfOutputs + j) * numberOfNetworks;
+			double *delta = deltas + (e * numberOfOutputs + j) * numberOfNetworks;
+			for (int n = 0; n < numberOfNetworks; n++) {
+				double difference = desiredOutput - output[n];
+				totalCosts[n] += difference * difference;
+				delta[n] = 2 * difference * output[n] * (1 - output[n]);
+			}
+		}
+	}
+
+	// Same steps as nn_Network__backwardPass, but each layer's updates are applied as soon as the deltas for
+	// the layer below have been calculated, since its weights aren't needed after that
+	double *updates = malloc(sizeof(double) * numberOfNetworks);
+	double *scales = malloc(sizeof(double) * numberOfNetworks);
+	for (int n = 0; n < numberOfNetworks; n++) {
+		scales[n] = trainingIncrements[n] / numberOfExamples;
+	}
+	for (int layer = this->numberOfLayers - 1; layer >= 1; layer--) {
+		int numberOfNodes = this->layerSizes[layer];
+		int numberOfNodesBelow = this->layerSizes[layer - 1];
+		double *weights = this->layerWeights[layer];
+		double *activationsBelow = this->layerActivations[layer - 1];
+
+		double *deltasBelow = NULL;
+		if (layer > 1) {
+			deltasBelow = calloc((size_t)numberOfExamples * numberOfNodesBelow * numberOfNetworks, sizeof(double));
+			for (int e = 0; e < numberOfExamples; e++) {
+				for (int i = 0; i < numberOfNodesBelow; i++) {
+					double *deltaBelow = deltasBelow + (e * numberOfNodesBelow + i) * numberOfNetworks;
+					for (int j = 0; j < numberOfNodes; j++) {
+						double *delta = deltas + (e * numberOfNodes + j) * numberOfNetworks;
+						double *weight = weights + (i * numberOfNodes + j) * numberOfNetworks;
+						for (int n = 0; n < numberOfNetworks; n++) {
+							deltaBelow[n] += delta[n] * weight[n];
+						}
+					}
+					double *activation = activationsBelow + (e * numberOfNodesBelow + i) * numberOfNetworks;
+					for (int n = 0; n < numberOfNetworks; n++) {
+						deltaBelow[n] *= activation[n] * (1 - activation[n]);
+					}
+				}
+			}
+		}
+
+		// update for each weight is the sum across all examples of the delta times the activation below
+		for (int i = 0; i < numberOfNodesBelow; i++) {
+			for (int j = 0; j < numberOfNodes; j++) {
+				for (int n = 0; n < numberOfNetworks; n++) {
+					updates[n] = 0.0;
+				}
+				for (int e = 0; e < numberOfExamples; e++) {
+					double *activation = activationsBelow + (e * numberOfNodesBelow + i) * numberOfNetworks;
+					double *delta = deltas + (e * numberOfNodes + j) * numberOfNetworks;
+					for (int n = 0; n < numberOfNetworks; n++) {
+						updates[n] += activation[n] * delta[n];
+					}
+				}
+				double *weight = weights + (i * numberOfNodes + j) * numberOfNetworks;
+				for (int n = 0; n < numberOfNetworks; n++) {
+					weight[n] += updates[n] * scales[n];
+				}
+			}
+		}
+
+		free(deltas);
+		deltas = deltasBelow;
+	}
+
+	if (costs != NULL) {
+		for (int n = 0; n < numberOfNetworks; n++) {
+			costs[n] = totalCosts[n] / (numberOfExamples * numberOfOutputs);
+		}
+	}
+	free(scales);
+	free(updates);
+	free(totalCosts);
+}
+
+// Returns the outputs of one of the networks, which the caller needs to free.
+nn_Matrix *nn_Bundle_allocInference(nn_Bundle *this, nn_Matrix *inputs, int network) {
+	nn_Bundle__inference(this, inputs);
+	int numberOfOutputs = this->layerSizes[this->numberOfLayers - 1];
+	double *outputs = this->layerActivations[this->numberOfLayers - 1];
+	nn_Matrix *networkOutputs = nn_Matrix_alloc(inputs->rows, numberOfOutputs);
+	for (int i = 0; i < inputs->rows * numberOfOutputs; i++) {
+		networkOutputs->data[i] = outputs[i * this->numberOfNetworks + network];
+	}
+	return networkOutputs;
+}
+
+// `seeds` has one value for each network, and each network gets the same weights as
+// nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed would give it with that seed.
+void nn_Bundle_randomiseWeightsBetweenMinAndMax(nn_Bundle *this, double min, double max, unsigned int *seeds) {
+	for (int n = 0; n < this->numberOfNetworks; n++) {
+		unsigned long long state = nn_Network_randomState(seeds[n]);
+		for (int l = 1; l < this->numberOfLayers; l++) {
+			int numberOfWeightsInLayer = this->layerSizes[l - 1] * this->layerSizes[l];
+			for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
+				this->layerWeights[l][weight * this->numberOfNetworks + n] = nn_Network_random(&state) * (max - min) + min;
+			}
+		}
+	}
+}
+
+// `other` must have the same layout.
+void nn_Bundle_copyWeightsFromNetwork(nn_Bundle *this, int network, nn_Network *other) {
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		int numberOfWeightsInLayer = this->layerSizes[l - 1] * this->layerSizes[l];
+		for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
+			this->layerWeights[l][weight * this->numberOfNetworks + network] = other->layerWeights[l]->data[weight];
+		}
+	}
+}
+
+// `other` must have the same layout, e.g. to save or use the best network from a sweep.
+void nn_Bundle_copyWeightsToNetwork(nn_Bundle *this, int network, nn_Network *other) {
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		int numberOfWeightsInLayer = this->layerSizes[l - 1] * this->layerSizes[l];
+		for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
+			other->layerWeights[l]->data[weight] = this->layerWeights[l][weight * this->numberOfNetworks + network];
+		}
+	}
+}
+
+void nn_Bundle__allocActivations(nn_Bundle *this, int numberOfExamples) {
+	if (this->layerActivations != NULL && this->numberOfExamples == numberOfExamples) {
+		return;
+	}
+	nn_Bundle__freeActivations(this);
+	this->layerActivations = malloc(sizeof(double *) * this->numberOfLayers);
+	for (int l = 0; l < this->numberOfLayers; l++) {
+		this->layerActivations[l] = malloc(sizeof(double) * numberOfExamples * this->layerSizes[l] * this->numberOfNetworks);
+	}
+	this->numberOfExamples = numberOfExamples;
+}
+
+void nn_Bundle__freeActivations(nn_Bundle *this) {
+	if (this->layerActivations == NULL) {
+		return;
+	}
+	for (int l = 0; l < this->numberOfLayers; l++) {
+		free(this->layerActivations[l]);
+	}
+	free(this->layerActivations);
+	this->layerActivations = NULL;
+}
+
+// Forward pass of every network, leaving the activations in layerActivations.
+void nn_Bundle__inference(nn_Bundle *this, nn_Matrix *inputs) {
+	nn_Bundle__allocActivations(this, inputs->rows);
+	// every network gets the same inputs
+	double *activations = this->layerActivations[0];
+	for (int i = 0; i < inputs->rows * inputs->columns; i++) {
+		for (int n = 0; n < this->numberOfNetworks; n++) {
+			activations[i * this->numberOfNetworks + n] = inputs->data[i];
+		}
+	}
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		nn_Bundle__fillActivationsAtLayer(this, l);
+	}
+}
+
+void nn_Bundle__fillActivationsAtLayer(nn_Bundle *this, int layer) {
+	int numberOfNetworks = this->numberOfNetworks;
+	int numberOfNodes = this->layerSizes[layer];
+	int numberOfNodesBelow = this->layerSizes[layer - 1];
+	double *weights = this->layerWeights[layer];
+	double *activationsBelow = this->layerActivations[layer - 1];
+	for (int e = 0; e < this->numberOfExamples; e++) {
+		for (int j = 0; j < numberOfNodes; j++) {
+			double *activation = this->layerActivations[layer] + (e * numberOfNodes + j) * numberOfNetworks;
+			for (int n = 0; n < numberOfNetworks; n++) {
+				activation[n] = 0.0;
+			}
+			for (int i = 0; i < numberOfNodesBelow; i++) {
+				double *activationBelow = activationsBelow + (e * numberOfNodesBelow + i) * numberOfNetworks;
+				double *weight = weights + (i * numberOfNodes + j) * numberOfNetworks;
+				for (int n = 0; n < numberOfNetworks; n++) {
+					activation[n] += activationBelow[n] * weight[n];
+				}
+			}
+			for (int n = 0; n < numberOfNetworks; n++) {
+				activation[n] = nn_Network_activation(activation[n]);
+			}
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef __NN_BUNDLE_H__
+#define __NN_BUNDLE_H__
+
+
+#include "nn_Network.h"
+
+// Many networks with the same layout, trained together on the same examples (e.g. for ensembles or
+// hyperparameter sweeps). Weights are interleaved, so the same weight of every network is next to each other:
+// layerWeights[layer][(row * columns + column) * numberOfNetworks + network]
+typedef struct {
+	int numberOfLayers;
+	int numberOfNetworks;
+	int *layerSizes;	// number of nodes at each layer, including the inputs at index 0
+	double **layerWeights;	// index 0 is unused like in nn_Network
+	double **layerActivations;	// [layer][(example * nodes + node) * numberOfNetworks + network]
+	int numberOfExamples;	// that layerActivations was allocated for
+} nn_Bundle;
+
+nn_Bundle *nn_Bundle_alloc(char *layout, int numberOfNetworks);
+void nn_Bundle_free(nn_Bundle *this);
+
+void nn_Bundle_train(nn_Bundle *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double *trainingIncrements, double *costs);
+nn_Matrix *nn_Bundle_allocInference(nn_Bundle *this, nn_Matrix *inputs, int network);
+
+void nn_Bundle_randomiseWeightsBetweenMinAndMax(nn_Bundle *this, double min, double max, unsigned int *seeds);
+void nn_Bundle_copyWeightsFromNetwork(nn_Bundle *this, int network, nn_Network *other);
+void nn_Bundle_copyWeightsToNetwork(nn_Bundle *this, int network, nn_Network *other);
+
+
+#endif
@@ -0,0 +1,143 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "nn_Bundle.h"
+
+int main() {
+	// Test nn_Bundle_alloc, scenario: layout and interleaved weights
+	{
+		nn_Bundle *bundle = nn_Bundle_alloc("2, 3, 1", 4);
+		assert(bundle->numberOfLayers == 3);
+		assert(bundle->numberOfNetworks == 4);
+		assert(bundle->layerSizes[0] == 2);
+		assert(bundle->layerSizes[1] == 3);
+		assert(bundle->layerSizes[2] == 1);
+
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Bundle_copyWeightsFromNetwork(bundle, 2, network);
+		// row 1, column 2 of the first layer's weights, for network 2
+		assert(bundle->layerWeights[1][(1 * 3 + 2) * 4 + 2] == -2.0);
+		assert(bundle->layerWeights[1][(1 * 3 + 2) * 4 + 1] == 0.0);
+
+		nn_Network *copy = nn_Network_alloc("2, 3, 1");
+		nn_Bundle_copyWeightsToNetwork(bundle, 2, copy);
+		assert(nn_Matrix_get(copy->layerWeights[1], 0, 0) == -2.0);
+		assert(nn_Matrix_get(copy->layerWeights[2], 2, 0) == 1.0);
+		nn_Network_free(copy);
+		nn_Network_free(network);
+		nn_Bundle_free(bundle);
+	}
+
+	// Test nn_Bundle_allocInference, scenario: 2-3-1 network (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Bundle *bundle = nn_Bundle_alloc("2, 3, 1", 3);
+		nn_Bundle_copyWeightsFromNetwork(bundle, 1, network);
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(1, 2, 1.0, 0.0);
+		nn_Matrix *outputs = nn_Bundle_allocInference(bundle, inputs, 1);
+		assert(outputs->rows == 1 && outputs->columns == 1);
+		assert(nn_Matrix_get(outputs, 0, 0) > 0.681 && nn_Matrix_get(outputs, 0, 0) < 0.682);
+		nn_Matrix_free(outputs);
+		// all weights 0 for the other networks
+		outputs = nn_Bundle_allocInference(bundle, inputs, 0);
+		assert(nn_Matrix_get(outputs, 0, 0) == 0.5);
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(inputs);
+		nn_Bundle_free(bundle);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Bundle_train, scenario: each network trains the same as nn_Network_train with its own increment
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *outputs = nn_Matrix_allocWithValues(4, 1,
+			1.0,
+			0.0,
+			0.0,
+			1.0
+		);
+		int numberOfNetworks = 5;
+		unsigned int seeds[5] = { 1, 2, 3, 4, 5 };
+		double trainingIncrements[5] = { 0.5, 1.0, 2.0, 4.0, 8.0 };
+		double costs[5];
+		nn_Bundle *bundle = nn_Bundle_alloc("2, 4, 3, 1", numberOfNetworks);
+		nn_Bundle_randomiseWeightsBetweenMinAndMax(bundle, -3.0, 3.0, seeds);
+		nn_Network *networks[5];
+		for (int n = 0; n < numberOfNetworks; n++) {
+			networks[n] = nn_Network_alloc("2, 4, 3, 1");
+			nn_Bundle_copyWeightsToNetwork(bundle, n, networks[n]);
+		}
+
+		for (int step = 0; step < 20; step++) {
+			nn_Bundle_train(bundle, inputs, outputs, trainingIncrements, costs);
+			for (int n = 0; n < numberOfNetworks; n++) {
+				double cost = nn_Network_train(networks[n], inputs, outputs, trainingIncrements[n]);
+				assert(fabs(cost - costs[n]) < 1e-12);
+			}
+		}
+		nn_Network *trained = nn_Network_alloc("2, 4, 3, 1");
+		for (int n = 0; n < numberOfNetworks; n++) {
+			nn_Bundle_copyWeightsToNetwork(bundle, n, trained);
+			for (int l = 1; l < trained->numberOfLayers; l++) {
+				for (int w = 0; w < trained->layerWeights[l]->rows * trained->layerWeights[l]->columns; w++) {
+					assert(fabs(trained->layerWeights[l]->data[w] - networks[n]->layerWeights[l]->data[w]) < 1e-12);
+				}
+			}
+			nn_Network_free(networks[n]);
+		}
+		nn_Network_free(trained);
+		nn_Bundle_free(bundle);
+		nn_Matrix_free(inputs);
+		nn_Matrix_free(outputs);
+	}
+
+	// Test nn_Bundle_randomiseWeightsBetweenMinAndMax, scenario: a network's weights only depend on its seed
+	{
+		unsigned int seeds[3] = { 7, 8, 7 };
+		nn_Bundle *bundle = nn_Bundle_alloc("2, 3, 1", 3);
+		nn_Bundle_randomiseWeightsBetweenMinAndMax(bundle, -3.0, 3.0, seeds);
+		unsigned int otherSeeds[1] = { 7 };
+		nn_Bundle *otherBundle = nn_Bundle_alloc("2, 3, 1", 1);
+		nn_Bundle_randomiseWeightsBetweenMinAndMax(otherBundle, -3.0, 3.0, otherSeeds);
+		for (int w = 0; w < 2 * 3; w++) {
+			assert(bundle->layerWeights[1][w * 3] >= -3.0 && bundle->layerWeights[1][w * 3] < 3.0);
+			assert(bundle->layerWeights[1][w * 3] == bundle->layerWeights[1][w * 3 + 2]);
+			assert(bundle->layerWeights[1][w * 3] == otherBundle->layerWeights[1][w]);
+		}
+		assert(bundle->layerWeights[1][0] != bundle->layerWeights[1][1]);
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -3.0, 3.0, 8);
+		for (int w = 0; w < 3; w++) {
+			assert(bundle->layerWeights[2][w * 3 + 1] == network->layerWeights[2]->data[w]);
+		}
+		nn_Network_free(network);
+		nn_Bundle_free(otherBundle);
+		nn_Bundle_free(bundle);
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdlib.h>	// malloc, free
+#include <string.h>	// strlen, strcpy
+#include <stdio.h>	// sprintf, remove
+#include <pthread.h>	// pthread_create, pthread_join, pthread_mutex_*, pthread_cond_*
+
+#include "nn_Checkpointer.h"
+
+// Writes checkpoints of a network in the background, so training only stops for as long as it takes to copy
+// the weights. Each checkpoint goes to its own file ("<prefix>-<step>.nn"), so writing them doesn't contend
+// with the '.lock' file of the network's main file.
+
+// 'private' functions
+void *nn_Checkpointer__run(void *checkpointer);
+void nn_Checkpointer__keepStep(nn_Checkpointer *this, int step);
+
+// An `interval` below 1 is taken as 1.
+nn_Checkpointer *nn_Checkpointer_alloc(nn_Network *network, char *filenamePrefix, int interval, int numberToKeep,
+		void (*onComplete)(char *filename, int result, void *context), void *context) {
+	nn_Checkpointer *this = malloc(sizeof(nn_Checkpointer));
+	this->filenamePrefix = malloc(sizeof(char) * (strlen(filenamePrefix) + 1));
+	strcpy(this->filenamePrefix, filenamePrefix);
+	this->interval = interval < 1 ? 1 : interval;
+	this->numberToKeep = numberToKeep;
+	this->onComplete = onComplete;
+	this->context = context;
+
+	pthread_mutex_init(&this->mutex, NULL);
+	pthread_cond_init(&this->condition, NULL);
+	// allocate the snapshots up front, so taking a checkpoint is only a copy
+	this->pendingSnapshot = nn_Network_allocCopy(network);
+	this->pendingStep = -1;
+	this->writingSnapshot = nn_Network_allocCopy(network);
+	this->writing = false;
+	this->stop = false;
+	this->keptSteps = numberToKeep > 0 ? malloc(sizeof(int) * numberToKeep) : NULL;
+	this->numberOfKeptSteps = 0;
+	this->oldestKeptStep = 0;
+
+	pthread_create(&this->thread, NULL, nn_Checkpointer__run, this);
+	return this;
+}
+
+// Waits for any checkpoints that have been taken to be written before freeing.
+void nn_Checkpointer_free(nn_Checkpointer *this) {
+	pthread_mutex_lock(&this->mutex);
+	this->stop = true;
+	pthread_cond_broadcast(&this->condition);
+	pthread_mutex_unlock(&this->mutex);
+	pthread_join(this->thread, NULL);
+
+	pthread_mutex_destroy(&this->mutex);
+	pthread_cond_destroy(&this->condition);
+	nn_Network_free(this->pendingSnapshot);
+	nn_Network_free(this->writingSnapshot);
+	free(this->keptSteps);
+	free(this->filenamePrefix);
+	free(this);
+}
+
+// Call after each training step, returns true if a snapshot was taken for this step. If the previous
+// snapshot is still waiting to be written, it's replaced by this newer one.
+bool nn_Checkpointer_checkpoint(nn_Checkpointer *this, nn_Network *network, int step) {
+	if (step % this->interval != 0) {
+		return false;
+	}
+	pthread_mutex_lock(&this->mutex);
+	nn_Network_copyWeightsFromNetwork(this->pendingSnapshot, network);
+	this->pendingStep = step;
+	pthread_cond_broadcast(&this->condition);
+	pthread_mutex_unlock(&this->mutex);
+	return true;
+}
+
+// Blocks until every snapshot taken so far has been written.
+void nn_Checkpointer_wait(nn_Checkpointer *this) {
+	pthread_mutex_lock(&this->mutex);
+	while (this->pendingStep >= 0 || this->writing) {
+		pthread_cond_wait(&this->condition, &this->mutex);
+	}
+	pthread_mutex_unlock(&this->mutex);
+}
+
+// The caller needs to free the returned string.
+char *nn_Checkpointer_allocFilenameForStep(nn_Checkpointer *this, int step) {
+	// enough room for the prefix, '-', a 32 bit int, ".nn" and '\0'
+	char *filename = malloc(sizeof(char) * (strlen(this->filenamePrefix) + 16));
+	sprintf(filename, "%s-%d.nn", this->filenamePrefix, step);
+	return filename;
+}
+
+void *nn_Checkpointer__run(void *checkpointer) {
+	nn_Checkpointer *this = checkpointer;
+	pthread_mutex_lock(&this->mutex);
+	while (1) {
+		while (this->pendingStep < 0 && !this->stop) {
+			pthread_cond_wait(&this->condition, &this->mutex);
+		}
+		if (this->pendingStep < 0) {
+			// stopping, and everything has been written
+			break;
+		}
+		// Swap the snapshots, so the training thread can take another one while this one is written
+		nn_Network *snapshot = this->pendingSnapshot;
+		this->pendingSnapshot = this->writingSnapshot;
+		this->writingSnapshot = snapshot;
+		int step = this->pendingStep;
+		this->pendingStep = -1;
+		this->writing = true;
+		pthread_mutex_unlock(&this->mutex);
+
+		char *filename = nn_Checkpointer_allocFilenameForStep(this, step);
+		int result = nn_Network_writeToFile(snapshot, filename);
+		if (result == 0) {
+			nn_Checkpointer__keepStep(this, step);
+		}
+		if (this->onComplete != NULL) {
+			this->onComplete(filename, result, this->context);
+		}
+		free(filename);
+
+		pthread_mutex_lock(&this->mutex);
+		this->writing = false;
+		pthread_cond_broadcast(&this->condition);
+	}
+	pthread_mutex_unlock(&this->mutex);
+	return NULL;
+}
+
+// Remembers that the file for `step` was written, and removes the oldest file if there are too many.
+void nn_Checkpointer__keepStep(nn_Checkpointer *this, int step) {
+	if (this->numberToKeep <= 0) {
+		return;
+	}
+	if (this->numberOfKeptSteps == this->numberToKeep) {
+		char *oldestFilename = nn_Checkpointer_allocFilenameForStep(this, this->keptSteps[this->oldestKeptStep]);
+		remove(oldestFilename);
+		free(oldestFilename);
+		this->keptSteps[this->oldestKeptStep] = step;
+		this->oldestKeptStep = (this->oldestKeptStep + 1) % this->numberToKeep;
+	}
+	else {
+		this->keptSteps[(this->oldestKeptStep + this->numberOfKeptSteps) % this->numberToKeep] = step;
+		this->numberOfKeptSteps++;
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef __NN_CHECKPOINTER_H__
+#define __NN_CHECKPOINTER_H__
+
+
+#include <stdbool.h>	// bool, true, false
+#include <pthread.h>	// pthread_t, pthread_mutex_t, pthread_cond_t
+
+#include "nn_Network.h"
+
+typedef struct {
+	char *filenamePrefix;
+	int interval;	// checkpoint every `interval` steps
+	int numberToKeep;	// older checkpoint files are removed, 0 keeps them all
+	// Called from the background thread after each checkpoint file is written (or fails to be).
+	// `result` is the return value of nn_Network_writeToFile.
+	void (*onComplete)(char *filename, int result, void *context);
+	void *context;
+
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	// Two snapshots, so the training thread can take a new one while the last one is being written
+	nn_Network *pendingSnapshot;
+	int pendingStep;	// -1 when there is no pending snapshot
+	nn_Network *writingSnapshot;
+	bool writing;
+	bool stop;
+	int *keptSteps;	// circular list of steps whose files haven't been removed
+	int numberOfKeptSteps;
+	int oldestKeptStep;	// index into keptSteps
+} nn_Checkpointer;
+
+nn_Checkpointer *nn_Checkpointer_alloc(nn_Network *network, char *filenamePrefix, int interval, int numberToKeep,
+		void (*onComplete)(char *filename, int result, void *context), void *context);
+void nn_Checkpointer_free(nn_Checkpointer *this);
+
+bool nn_Checkpointer_checkpoint(nn_Checkpointer *this, nn_Network *network, int step);
+void nn_Checkpointer_wait(nn_Checkpointer *this);
+char *nn_Checkpointer_allocFilenameForStep(nn_Checkpointer *this, int step);
+
+
+#endif
@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nn_Checkpointer.h"
+
+// Test callback, counts completed checkpoints and remembers the last filename
+int numberOfCompletedCheckpoints = 0;
+char lastCompletedFilename[64];
+void onComplete(char *filename, int result, void *context) {
+	assert(result == 0);
+	assert(context == &numberOfCompletedCheckpoints);
+	numberOfCompletedCheckpoints++;
+	strcpy(lastCompletedFilename, filename);
+}
+
+int fileExists(char *filename) {
+	FILE *file = fopen(filename, "r");
+	if (file == NULL) {
+		return 0;
+	}
+	fclose(file);
+	return 1;
+}
+
+int main() {
+	nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 2,
+		0.0, 0.0,
+		0.0, 1.0,
+		1.0, 0.0,
+		1.0, 1.0
+	);
+	nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 1,
+		1.0,
+		0.0,
+		0.0,
+		1.0
+	);
+
+	// Test nn_Checkpointer_allocFilenameForStep, scenario: basic
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Checkpointer *checkpointer = nn_Checkpointer_alloc(network, "tmp", 1, 0, NULL, NULL);
+		char *filename = nn_Checkpointer_allocFilenameForStep(checkpointer, 42);
+		assert(strcmp(filename, "tmp-42.nn") == 0);
+		free(filename);
+		nn_Checkpointer_free(checkpointer);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Checkpointer_checkpoint, scenario: interval, retention and callback
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -3.0, 3.0);
+		nn_Checkpointer *checkpointer = nn_Checkpointer_alloc(network, "tmp", 2, 2, onComplete, &numberOfCompletedCheckpoints);
+		for (int step = 1; step <= 10; step++) {
+			nn_Network_train(network, trainingInputs, trainingOutputs, 0.3);
+			assert(nn_Checkpointer_checkpoint(checkpointer, network, step) == (step % 2 == 0));
+			// wait each time, so that no snapshots are replaced before they're written
+			nn_Checkpointer_wait(checkpointer);
+		}
+		assert(numberOfCompletedCheckpoints == 5);
+		assert(strcmp(lastCompletedFilename, "tmp-10.nn") == 0);
+		assert(!fileExists("tmp-2.nn"));
+		assert(!fileExists("tmp-4.nn"));
+		assert(!fileExists("tmp-6.nn"));
+		assert(fileExists("tmp-8.nn"));
+		assert(fileExists("tmp-10.nn"));
+
+		nn_Network *checkpoint = nn_Network_allocFromFile("tmp-10.nn");
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				assert(checkpoint->layerWeights[l]->data[w] == network->layerWeights[l]->data[w]);
+			}
+		}
+		nn_Network_free(checkpoint);
+		nn_Checkpointer_free(checkpointer);
+		nn_Network_free(network);
+		remove("tmp-8.nn");
+		remove("tmp-10.nn");
+	}
+
+	// Test nn_Checkpointer_checkpoint, scenario: training doesn't wait, last snapshot is always written
+	{
+		numberOfCompletedCheckpoints = 0;
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -3.0, 3.0);
+		nn_Checkpointer *checkpointer = nn_Checkpointer_alloc(network, "tmp", 1, 1, onComplete, &numberOfCompletedCheckpoints);
+		for (int step = 1; step <= 100; step++) {
+			nn_Network_train(network, trainingInputs, trainingOutputs, 0.3);
+			nn_Checkpointer_checkpoint(checkpointer, network, step);
+		}
+		nn_Checkpointer_free(checkpointer);
+		assert(numberOfCompletedCheckpoints >= 1);
+		assert(strcmp(lastCompletedFilename, "tmp-100.nn") == 0);
+		nn_Network *checkpoint = nn_Network_allocFromFile("tmp-100.nn");
+		assert(nn_Matrix_get(checkpoint->layerWeights[2], 1, 0) == nn_Matrix_get(network->layerWeights[2], 1, 0));
+		nn_Network_free(checkpoint);
+		nn_Network_free(network);
+		remove("tmp-100.nn");
+	}
+
+	// Test nn_Checkpointer_checkpoint, scenario: interval below 1, every step is checkpointed
+	{
+		numberOfCompletedCheckpoints = 0;
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Checkpointer *checkpointer = nn_Checkpointer_alloc(network, "tmp", 0, 1, onComplete, &numberOfCompletedCheckpoints);
+		assert(checkpointer->interval == 1);
+		assert(nn_Checkpointer_checkpoint(checkpointer, network, 1));
+		nn_Checkpointer_wait(checkpointer);
+		nn_Checkpointer_free(checkpointer);
+		checkpointer = nn_Checkpointer_alloc(network, "tmp", -3, 1, onComplete, &numberOfCompletedCheckpoints);
+		assert(nn_Checkpointer_checkpoint(checkpointer, network, 2));
+		nn_Checkpointer_free(checkpointer);
+		assert(numberOfCompletedCheckpoints == 2);
+		nn_Network_free(network);
+		remove("tmp-1.nn");
+		remove("tmp-2.nn");
+	}
+
+	nn_Matrix_free(trainingInputs);
+	nn_Matrix_free(trainingOutputs);
+
+	return 0;
+}
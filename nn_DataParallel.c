@@ -0,0 +1,218 @@
+#include <stdlib.h>	// malloc, free
+#include <string.h>	// memcpy
+#include <signal.h>	// kill, SIGKILL
+#include <sched.h>	// sched_yield
+#include <errno.h>	// errno, EINTR
+#include <time.h>	// nanosleep
+#include <unistd.h>	// fork, _exit
+#include <sys/mman.h>	// mmap, munmap
+#include <sys/wait.h>	// waitpid
+
+#include "nn_DataParallel.h"
+
+// Data parallel training across processes, e.g. one per NUMA node. Each worker process trains a copy of the
+// network on its own share of the examples. After each backward pass the workers add their updates together
+// through shared memory (each worker adds up its own slice of the weights from every worker, then they all
+// read the whole result), and apply the same total update, so every copy of the network stays identical.
+// Each step changes the weights the same way as one call to nn_Network_train with all the examples.
+
+// How often the workers are checked on while they're training
+#define NN_DATAPARALLEL_POLL_NANOSECONDS	1000000
+
+// 'private' functions
+void nn_DataParallel__runWorker(nn_DataParallelShared *shared, nn_Network *network, nn_Matrix *trainingDataInputs,
+		nn_Matrix *trainingDataOutputs, int worker, int numberOfSteps, double trainingIncrement);
+void nn_DataParallel__wait(nn_DataParallelShared *shared);
+double *nn_DataParallel__costs(nn_DataParallelShared *shared);
+double *nn_DataParallel__updates(nn_DataParallelShared *shared, int worker);
+double *nn_DataParallel__totalUpdates(nn_DataParallelShared *shared);
+double *nn_DataParallel__finalWeights(nn_DataParallelShared *shared);
+
+// Starts `numberOfWorkers` processes that each train on a share of the examples for `numberOfSteps` steps,
+// then copies the trained weights back into `network`. `finalCost` is set to the average cost of the last step.
+// Returns 0 on success, or an NN_ERROR_ code.
+int nn_DataParallel_train(nn_Network *network, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		int numberOfWorkers, int numberOfSteps, double trainingIncrement, double *finalCost) {
+	if (numberOfWorkers > trainingDataInputs->rows) {
+		numberOfWorkers = trainingDataInputs->rows;
+	}
+	// no workers (or no examples) would leave the network with the zeroed weights from the shared memory
+	if (numberOfWorkers < 1) {
+		return NN_ERROR_NO_WORKERS;
+	}
+	int numberOfWeights = 0;
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		numberOfWeights += network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+	}
+
+	// Memory shared with the worker processes, which are forked after it's mapped
+	size_t sharedSize = sizeof(nn_DataParallelShared) +
+			sizeof(double) * (numberOfWorkers + (size_t)numberOfWeights * (numberOfWorkers + 2));
+	nn_DataParallelShared *shared = mmap(NULL, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED) {
+		return NN_ERROR_SHARED_MEMORY;
+	}
+	atomic_init(&shared->barrierCount, 0);
+	atomic_init(&shared->barrierGeneration, 0);
+	shared->numberOfWorkers = numberOfWorkers;
+	shared->numberOfWeights = numberOfWeights;
+
+	pid_t *workers = malloc(sizeof(pid_t) * numberOfWorkers);
+	for (int w = 0; w < numberOfWorkers; w++) {
+		workers[w] = fork();
+		if (workers[w] < 0) {
+			// the workers already started would wait for this one forever
+			for (int started = 0; started < w; started++) {
+				kill(workers[started], SIGKILL);
+				waitpid(workers[started], NULL, 0);
+			}
+			free(workers);
+			munmap(shared, sharedSize);
+			return NN_ERROR_WORKER_FAILED;
+		}
+		if (workers[w] == 0) {
+			nn_DataParallel__runWorker(shared, network, trainingDataInputs, trainingDataOutputs, w, numberOfSteps, trainingIncrement);
+			// don't run atexit handlers or flush the parent's stdio buffers a second time
+			_exit(0);
+		}
+	}
+
+	// If any worker fails, the others would wait for it forever, so stop them all. Only the workers' own pids are
+	// waited for, so other children of the caller are left alone, and the workers are polled rather than waited for
+	// in order, so a failure is seen whichever worker it's in.
+	int result = 0;
+	int numberRunning = numberOfWorkers;
+	while (numberRunning > 0) {
+		for (int w = 0; w < numberOfWorkers; w++) {
+			if (workers[w] == 0) {
+				continue;	// already finished
+			}
+			int status;
+			pid_t finished = waitpid(workers[w], &status, WNOHANG);
+			if (finished == 0 || (finished < 0 && errno == EINTR)) {
+				continue;
+			}
+			workers[w] = 0;
+			numberRunning--;
+			if (finished < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				result = NN_ERROR_WORKER_FAILED;
+				for (int other = 0; other < numberOfWorkers; other++) {
+					if (workers[other] != 0) {
+						kill(workers[other], SIGKILL);
+					}
+				}
+			}
+		}
+		if (numberRunning > 0) {
+			struct timespec pollInterval = { 0, NN_DATAPARALLEL_POLL_NANOSECONDS };
+			nanosleep(&pollInterval, NULL);
+		}
+	}
+	free(workers);
+
+	if (result == 0) {
+		double *finalWeights = nn_DataParallel__finalWeights(shared);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeightsInLayer = network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+			memcpy(network->layerWeights[l]->data, finalWeights, sizeof(double) * numberOfWeightsInLayer);
+			finalWeights += numberOfWeightsInLayer;
+		}
+		double totalCost = 0.0;
+		for (int w = 0; w < numberOfWorkers; w++) {
+			totalCost += nn_DataParallel__costs(shared)[w];
+		}
+		*finalCost = totalCost / (trainingDataOutputs->rows * trainingDataOutputs->columns);
+	}
+
+	munmap(shared, sharedSize);
+	return result;
+}
+
+void nn_DataParallel__runWorker(nn_DataParallelShared *shared, nn_Network *network, nn_Matrix *trainingDataInputs,
+		nn_Matrix *trainingDataOutputs, int worker, int numberOfSteps, double trainingIncrement) {
+	int numberOfWorkers = shared->numberOfWorkers;
+	int numberOfWeights = shared->numberOfWeights;
+	int firstRow = trainingDataInputs->rows * worker / numberOfWorkers;
+	int numberOfRows = trainingDataInputs->rows * (worker + 1) / numberOfWorkers - firstRow;
+	nn_Matrix *inputs = nn_Matrix_allocWithRows(trainingDataInputs, firstRow, numberOfRows);
+	nn_Matrix *outputs = nn_Matrix_allocWithRows(trainingDataOutputs, firstRow, numberOfRows);
+	nn_Matrix **layerUpdates = nn_Network_allocLayerUpdates(network);
+	double *updates = nn_DataParallel__updates(shared, worker);
+	double *totalUpdates = nn_DataParallel__totalUpdates(shared);
+	// the slice of the weights this worker adds up
+	int firstWeight = numberOfWeights * worker / numberOfWorkers;
+	int endWeight = numberOfWeights * (worker + 1) / numberOfWorkers;
+
+	for (int step = 0; step < numberOfSteps; step++) {
+		nn_DataParallel__costs(shared)[worker] = nn_Network_fillUpdates(network, inputs, outputs, layerUpdates);
+		int offset = 0;
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeightsInLayer = layerUpdates[l]->rows * layerUpdates[l]->columns;
+			memcpy(updates + offset, layerUpdates[l]->data, sizeof(double) * numberOfWeightsInLayer);
+			offset += numberOfWeightsInLayer;
+		}
+		nn_DataParallel__wait(shared);
+
+		// add up this worker's slice
+		for (int weight = firstWeight; weight < endWeight; weight++) {
+			double total = 0.0;
+			for (int w = 0; w < numberOfWorkers; w++) {
+				total += nn_DataParallel__updates(shared, w)[weight];
+			}
+			totalUpdates[weight] = total;
+		}
+		nn_DataParallel__wait(shared);
+
+		// every worker applies the same total
+		offset = 0;
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeightsInLayer = layerUpdates[l]->rows * layerUpdates[l]->columns;
+			memcpy(layerUpdates[l]->data, totalUpdates + offset, sizeof(double) * numberOfWeightsInLayer);
+			offset += numberOfWeightsInLayer;
+		}
+		nn_Network_applyUpdates(network, layerUpdates, trainingIncrement / trainingDataInputs->rows);
+	}
+
+	if (worker == 0) {
+		double *finalWeights = nn_DataParallel__finalWeights(shared);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeightsInLayer = network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+			memcpy(finalWeights, network->layerWeights[l]->data, sizeof(double) * numberOfWeightsInLayer);
+			finalWeights += numberOfWeightsInLayer;
+		}
+	}
+
+	nn_Network_freeLayerUpdates(network, layerUpdates);
+	nn_Matrix_free(inputs);
+	nn_Matrix_free(outputs);
+}
+
+// Spinning barrier across the worker processes, every worker has to call this before any of them carry on.
+void nn_DataParallel__wait(nn_DataParallelShared *shared) {
+	int generation = atomic_load_explicit(&shared->barrierGeneration, memory_order_acquire);
+	if (atomic_fetch_add_explicit(&shared->barrierCount, 1, memory_order_acq_rel) == shared->numberOfWorkers - 1) {
+		// last one here, let everyone go
+		atomic_store_explicit(&shared->barrierCount, 0, memory_order_relaxed);
+		atomic_store_explicit(&shared->barrierGeneration, generation + 1, memory_order_release);
+		return;
+	}
+	while (atomic_load_explicit(&shared->barrierGeneration, memory_order_acquire) == generation) {
+		sched_yield();
+	}
+}
+
+double *nn_DataParallel__costs(nn_DataParallelShared *shared) {
+	return (double *)(shared + 1);
+}
+
+double *nn_DataParallel__updates(nn_DataParallelShared *shared, int worker) {
+	return nn_DataParallel__costs(shared) + shared->numberOfWorkers + (size_t)shared->numberOfWeights * worker;
+}
+
+double *nn_DataParallel__totalUpdates(nn_DataParallelShared *shared) {
+	return nn_DataParallel__updates(shared, shared->numberOfWorkers);
+}
+
+double *nn_DataParallel__finalWeights(nn_DataParallelShared *shared) {
+	return nn_DataParallel__totalUpdates(shared) + shared->numberOfWeights;
+}
@@ -0,0 +1,29 @@
+#ifndef __NN_DATAPARALLEL_H__
+#define __NN_DATAPARALLEL_H__
+
+
+#include <stdatomic.h>	// atomic_int
+
+#include "nn_Network.h"
+
+#define NN_ERROR_WORKER_FAILED	3
+#define NN_ERROR_SHARED_MEMORY	4
+#define NN_ERROR_NO_WORKERS	7
+
+// Lives at the start of the memory shared by all the worker processes, followed by (all as doubles):
+// - total cost for each worker (numberOfWorkers)
+// - updates from each worker (numberOfWorkers x numberOfWeights)
+// - updates added together from all workers (numberOfWeights)
+// - final weights, written by worker 0 (numberOfWeights)
+typedef struct {
+	atomic_int barrierCount;
+	atomic_int barrierGeneration;
+	int numberOfWorkers;
+	int numberOfWeights;
+} nn_DataParallelShared;
+
+int nn_DataParallel_train(nn_Network *network, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		int numberOfWorkers, int numberOfSteps, double trainingIncrement, double *finalCost);
+
+
+#endif
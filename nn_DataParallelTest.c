@@ -0,0 +1,118 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>	// fork, _exit
+#include <sys/wait.h>	// waitpid
+
+#include "nn_DataParallel.h"
+
+int main() {
+	// Test nn_DataParallel_train, scenario: same results as nn_Network_train with all the examples
+	{
+		nn_Network *expected = nn_Network_alloc("3, 5, 4, 2");
+		nn_Network_randomiseWeightsBetweenMinAndMax(expected, -1.0, 1.0);
+		nn_Network *network = nn_Network_allocCopy(expected);
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(7, 3);
+		nn_Matrix *trainingOutputs = nn_Matrix_alloc(7, 2);
+		for (int i = 0; i < 7 * 3; i++) {
+			trainingInputs->data[i] = (i % 5) / 4.0;
+		}
+		for (int i = 0; i < 7 * 2; i++) {
+			trainingOutputs->data[i] = (i % 3) / 2.0;
+		}
+
+		double expectedError;
+		for (int step = 0; step < 10; step++) {
+			expectedError = nn_Network_train(expected, trainingInputs, trainingOutputs, 0.5);
+		}
+		double error;
+		int result = nn_DataParallel_train(network, trainingInputs, trainingOutputs, 3, 10, 0.5, &error);
+		assert(result == 0);
+		assert(fabs(error - expectedError) < 1e-12);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				assert(fabs(network->layerWeights[l]->data[w] - expected->layerWeights[l]->data[w]) < 1e-12);
+			}
+		}
+
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+		nn_Network_free(expected);
+	}
+
+	// Test nn_DataParallel_train, scenario: more workers than examples (see 2-3-2_example_spreadsheet.ods)
+	{
+		nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 0.0,
+			0.0, 1.0
+		);
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0, 2.0,
+			0.0, -2.0,
+			1.0, -1.0
+		);
+		double error;
+		int result = nn_DataParallel_train(network, trainingInputs, trainingOutputs, 8, 1, 0.3, &error);
+		assert(result == 0);
+		assert(error > 0.280 && error < 0.281);
+		assert(nn_Matrix_get(network->layerWeights[1], 0, 1) > -0.005 && nn_Matrix_get(network->layerWeights[1], 0, 1) < -0.004);
+		assert(nn_Matrix_get(network->layerWeights[2], 2, 1) > -0.986 && nn_Matrix_get(network->layerWeights[2], 2, 1) < -0.985);
+
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+	}
+
+	// Test nn_DataParallel_train, scenario: no workers, the network isn't changed
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[2], 1.0, 2.0, 3.0);
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(4, 2);
+		nn_Matrix *trainingOutputs = nn_Matrix_alloc(4, 1);
+		double error = -1.0;
+		assert(nn_DataParallel_train(network, trainingInputs, trainingOutputs, 0, 5, 0.5, &error) == NN_ERROR_NO_WORKERS);
+		assert(nn_DataParallel_train(network, trainingInputs, trainingOutputs, -2, 5, 0.5, &error) == NN_ERROR_NO_WORKERS);
+		assert(error == -1.0);
+		assert(nn_Matrix_get(network->layerWeights[2], 2, 0) == 3.0);
+
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+	}
+
+	// Test nn_DataParallel_train, scenario: other children of the caller are left alone, even if they fail
+	{
+		pid_t other = fork();
+		if (other == 0) {
+			_exit(3);
+		}
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(4, 2);
+		nn_Matrix *trainingOutputs = nn_Matrix_alloc(4, 1);
+		double error;
+		assert(nn_DataParallel_train(network, trainingInputs, trainingOutputs, 2, 5, 0.5, &error) == 0);
+		int status;
+		assert(waitpid(other, &status, 0) == other);
+		assert(WIFEXITED(status) && WEXITSTATUS(status) == 3);
+
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+	}
+
+	return 0;
+}
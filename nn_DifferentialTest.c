@@ -0,0 +1,409 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>	// malloc, free, llabs
+#include <string.h>	// memcpy
+#include <stdint.h>	// int64_t
+#include <math.h>
+
+#include "nn_Network.h"
+
+// Checks the (optimised) library against a reference implementation, which is the original straightforward
+// scalar code, copied here so it stays the same when the library changes. Random layouts, batch sizes and weights
+// are run through inference, training and files with both, and the results have to agree to within a few ULPs, or
+// a small relative error where the summation order is allowed to differ (e.g. blocked kernels).
+// The seed is fixed, so any failure can be reproduced.
+
+#define NN_DIFFERENTIAL_SEED	12345
+#define NN_DIFFERENTIAL_NUMBER_OF_CASES	200
+#define NN_DIFFERENTIAL_TRAINING_STEPS	5
+#define NN_DIFFERENTIAL_MAX_ULPS	64
+#define NN_DIFFERENTIAL_MAX_RELATIVE_ERROR	1e-12
+
+// 'private' functions
+nn_Matrix *nn_DifferentialTest__allocReferenceInference(nn_Network *network, nn_Matrix *inputs, nn_Matrix **layerActivations);
+double nn_DifferentialTest__referenceTrain(nn_Network *network, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement);
+double nn_DifferentialTest__sigmoid(double input);
+nn_Network *nn_DifferentialTest__allocRandomNetwork(unsigned long long *state);
+void nn_DifferentialTest__fillRandomInputs(nn_Matrix *matrix, unsigned long long *state);
+int64_t nn_DifferentialTest__ulps(double a, double b);
+bool nn_DifferentialTest__isClose(double a, double b, double maxRelativeError);
+bool nn_DifferentialTest__matricesAreClose(nn_Matrix *a, nn_Matrix *b, double maxRelativeError);
+bool nn_DifferentialTest__weightsAreClose(nn_Network *a, nn_Network *b, double maxRelativeError);
+
+int main() {
+	// Test reference implementation, scenario: inference (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Matrix *expected = nn_DifferentialTest__allocReferenceInference(network, inputs, NULL);
+		assert(nn_Matrix_get(expected, 0, 0) > 0.499 && nn_Matrix_get(expected, 0, 0) < 0.501);
+		assert(nn_Matrix_get(expected, 1, 0) > 0.462 && nn_Matrix_get(expected, 1, 0) < 0.463);
+		assert(nn_Matrix_get(expected, 2, 0) > 0.681 && nn_Matrix_get(expected, 2, 0) < 0.682);
+		assert(nn_Matrix_get(expected, 3, 0) > 0.611 && nn_Matrix_get(expected, 3, 0) < 0.612);
+		nn_Matrix *outputs = nn_Network_allocInference(network, inputs);
+		assert(nn_DifferentialTest__matricesAreClose(outputs, expected, 0.0));
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(expected);
+		nn_Matrix_free(inputs);
+		nn_Network_free(network);
+	}
+
+	// Test reference implementation, scenario: training (see 2-3-2_example_spreadsheet.ods)
+	{
+		nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 0.0,
+			0.0, 1.0
+		);
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0, 2.0,
+			0.0, -2.0,
+			1.0, -1.0
+		);
+		nn_Network *expected = nn_Network_allocCopy(network);
+		double expectedError = nn_DifferentialTest__referenceTrain(expected, trainingInputs, trainingOutputs, 0.3);
+		assert(expectedError > 0.280 && expectedError < 0.281);
+		assert(nn_Matrix_get(expected->layerWeights[1], 0, 1) > -0.005 && nn_Matrix_get(expected->layerWeights[1], 0, 1) < -0.004);
+		assert(nn_Matrix_get(expected->layerWeights[1], 1, 2) > -2.007 && nn_Matrix_get(expected->layerWeights[1], 1, 2) < -2.006);
+		assert(nn_Matrix_get(expected->layerWeights[2], 0, 1) > 2.009 && nn_Matrix_get(expected->layerWeights[2], 0, 1) < 2.010);
+		assert(nn_Matrix_get(expected->layerWeights[2], 2, 0) > 0.991 && nn_Matrix_get(expected->layerWeights[2], 2, 0) < 0.992);
+		double error = nn_Network_train(network, trainingInputs, trainingOutputs, 0.3);
+		assert(nn_DifferentialTest__isClose(error, expectedError, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+		assert(nn_DifferentialTest__weightsAreClose(network, expected, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(expected);
+		nn_Network_free(network);
+	}
+
+	// Test nn_DifferentialTest__isClose, scenario: ULPs and relative error
+	{
+		assert(nn_DifferentialTest__ulps(1.0, nextafter(1.0, 2.0)) == 1);
+		assert(nn_DifferentialTest__ulps(-0.0, 0.0) == 0);
+		assert(nn_DifferentialTest__ulps(-1e-300, 1e-300) > NN_DIFFERENTIAL_MAX_ULPS);
+		assert(nn_DifferentialTest__isClose(1.0, 1.0 + 1e-15, 0.0));
+		assert(!nn_DifferentialTest__isClose(1.0, 1.0 + 1e-9, 1e-12));
+		assert(nn_DifferentialTest__isClose(1.0, 1.0 + 1e-9, 1e-8));
+		assert(!nn_DifferentialTest__isClose(1.0, NAN, 1.0));
+	}
+
+	unsigned long long state = NN_DIFFERENTIAL_SEED;
+
+	// Test nn_Network_allocInference and nn_Network_inferenceForTraining, scenario: random layouts, batch sizes
+	// and weights, with and without blocked kernels
+	for (int c = 0; c < NN_DIFFERENTIAL_NUMBER_OF_CASES; c++) {
+		nn_Network *network = nn_DifferentialTest__allocRandomNetwork(&state);
+		nn_Matrix *inputs = nn_Matrix_alloc(1 + (int)(nn_Network_random(&state) * 64), network->numberOfInputs);
+		nn_DifferentialTest__fillRandomInputs(inputs, &state);
+		nn_Matrix **expectedActivations = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+		nn_Matrix *expected = nn_DifferentialTest__allocReferenceInference(network, inputs, expectedActivations);
+
+		nn_Matrix *outputs = nn_Network_allocInference(network, inputs);
+		assert(nn_DifferentialTest__matricesAreClose(outputs, expected, 0.0));
+		nn_Matrix_free(outputs);
+
+		nn_Network_inferenceForTraining(network, inputs);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			assert(nn_DifferentialTest__matricesAreClose(network->layerActivations[l], expectedActivations[l], 0.0));
+		}
+
+		// blocked kernels add up in a different order
+		network->layerBlockSizes = malloc(sizeof(int) * network->numberOfLayers);
+		for (int l = 0; l < network->numberOfLayers; l++) {
+			network->layerBlockSizes[l] = (int)(nn_Network_random(&state) * 33);
+		}
+		outputs = nn_Network_allocInference(network, inputs);
+		assert(nn_DifferentialTest__matricesAreClose(outputs, expected, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+		nn_Matrix_free(outputs);
+
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			nn_Matrix_free(expectedActivations[l]);
+		}
+		free(expectedActivations);
+		nn_Matrix_free(expected);
+		nn_Matrix_free(inputs);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_train and nn_Network_trainWithRecomputation, scenario: several steps with random layouts,
+	// batch sizes and weights
+	for (int c = 0; c < NN_DIFFERENTIAL_NUMBER_OF_CASES; c++) {
+		nn_Network *expected = nn_DifferentialTest__allocRandomNetwork(&state);
+		int numberOfExamples = 1 + (int)(nn_Network_random(&state) * 32);
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(numberOfExamples, expected->numberOfInputs);
+		nn_Matrix *trainingOutputs = nn_Matrix_alloc(numberOfExamples,
+				nn_Network_numberOfNodesAtLayerIndex(expected, expected->numberOfLayers - 1));
+		nn_DifferentialTest__fillRandomInputs(trainingInputs, &state);
+		for (int i = 0; i < trainingOutputs->rows * trainingOutputs->columns; i++) {
+			trainingOutputs->data[i] = nn_Network_random(&state);
+		}
+		double trainingIncrement = 0.01 + nn_Network_random(&state) * 2.0;
+		int checkpointInterval = 1 + (int)(nn_Network_random(&state) * 3);
+		nn_Network *network = nn_Network_allocCopy(expected);
+		nn_Network *recomputed = nn_Network_allocCopy(expected);
+
+		for (int step = 0; step < NN_DIFFERENTIAL_TRAINING_STEPS; step++) {
+			double expectedCost = nn_DifferentialTest__referenceTrain(expected, trainingInputs, trainingOutputs, trainingIncrement);
+			double cost = nn_Network_train(network, trainingInputs, trainingOutputs, trainingIncrement);
+			double recomputedCost = nn_Network_trainWithRecomputation(recomputed, trainingInputs, trainingOutputs,
+					trainingIncrement, checkpointInterval);
+			assert(nn_DifferentialTest__isClose(cost, expectedCost, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+			assert(nn_DifferentialTest__isClose(recomputedCost, expectedCost, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+			assert(nn_DifferentialTest__weightsAreClose(network, expected, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+			assert(nn_DifferentialTest__weightsAreClose(recomputed, expected, NN_DIFFERENTIAL_MAX_RELATIVE_ERROR));
+		}
+
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(recomputed);
+		nn_Network_free(network);
+		nn_Network_free(expected);
+	}
+
+	// Test nn_Network_writeToFileWithPrecision and nn_Network_allocFromFile, scenario: random layouts and weights,
+	// doubles are exact, half and bfloat16 are within their rounding error
+	for (int c = 0; c < NN_DIFFERENTIAL_NUMBER_OF_CASES / 10; c++) {
+		nn_Network *network = nn_DifferentialTest__allocRandomNetwork(&state);
+		int precisions[] = { NN_PRECISION_DOUBLE, NN_PRECISION_HALF, NN_PRECISION_BFLOAT16 };
+		double maxRelativeErrors[] = { 0.0, 1.0 / 2048, 1.0 / 256 };	// half of the last place of each mantissa
+		for (int p = 0; p < 3; p++) {
+			assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", precisions[p]) == 0);
+			nn_Network *fromFile = nn_Network_allocFromFile("tmp.nn");
+			assert(fromFile != NULL);
+			assert(fromFile->numberOfLayers == network->numberOfLayers);
+			assert(fromFile->numberOfInputs == network->numberOfInputs);
+			for (int l = 1; l < network->numberOfLayers; l++) {
+				nn_Matrix *weights = network->layerWeights[l];
+				assert(fromFile->layerWeights[l]->rows == weights->rows);
+				assert(fromFile->layerWeights[l]->columns == weights->columns);
+				for (int i = 0; i < weights->rows * weights->columns; i++) {
+					double error = fabs(fromFile->layerWeights[l]->data[i] - weights->data[i]);
+					// half rounds to multiples of 2^-24 near 0 (subnormals)
+					assert(error <= fabs(weights->data[i]) * maxRelativeErrors[p] + (p == 1 ? 1.0 / 33554432 : 0.0));
+				}
+			}
+			nn_Network_free(fromFile);
+			remove("tmp.nn");
+		}
+		nn_Network_free(network);
+	}
+
+	return 0;
+}
+
+// The original inference, a plain dot product then sigmoid at each layer. If `layerActivations` isn't NULL, it's
+// filled with the activations at every layer (index 0 is the inputs, and isn't allocated).
+nn_Matrix *nn_DifferentialTest__allocReferenceInference(nn_Network *network, nn_Matrix *inputs, nn_Matrix **layerActivations) {
+	nn_Matrix *previousActivations = inputs;
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		nn_Matrix *weights = network->layerWeights[l];
+		nn_Matrix *activations = nn_Matrix_alloc(inputs->rows, weights->columns);
+		for (int row = 0; row < previousActivations->rows; row++) {
+			for (int column = 0; column < weights->columns; column++) {
+				double total = 0.0;
+				for (int i = 0; i < previousActivations->columns; i++) {
+					total += previousActivations->data[row * previousActivations->columns + i] *
+							weights->data[i * weights->columns + column];
+				}
+				activations->data[row * activations->columns + column] = nn_DifferentialTest__sigmoid(total);
+			}
+		}
+		if (layerActivations != NULL) {
+			layerActivations[l] = activations;
+		}
+		else if (previousActivations != inputs) {
+			nn_Matrix_free(previousActivations);
+		}
+		previousActivations = activations;
+	}
+	if (layerActivations != NULL) {
+		// the caller frees every layer, so give them their own copy of the outputs
+		nn_Matrix *outputs = nn_Matrix_alloc(previousActivations->rows, previousActivations->columns);
+		memcpy(outputs->data, previousActivations->data, sizeof(double) * outputs->rows * outputs->columns);
+		return outputs;
+	}
+	return previousActivations;
+}
+
+// The original training step, with the deltas, updates and cost worked out one value at a time.
+double nn_DifferentialTest__referenceTrain(nn_Network *network, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement) {
+	nn_Matrix **layerActivations = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+	layerActivations[0] = trainingDataInputs;
+	nn_Matrix *outputs = nn_DifferentialTest__allocReferenceInference(network, trainingDataInputs, layerActivations);
+
+	double totalCost = 0.0;
+	for (int i = 0; i < outputs->rows * outputs->columns; i++) {
+		totalCost += pow(trainingDataOutputs->data[i] - outputs->data[i], 2);
+	}
+
+	nn_Matrix **layerUpdates = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+	nn_Matrix *previousDeltas = NULL;
+	for (int layer = network->numberOfLayers - 1; layer >= 1; layer--) {
+		nn_Matrix *activations = layerActivations[layer];
+		nn_Matrix *deltas = nn_Matrix_alloc(activations->rows, activations->columns);
+		for (int example = 0; example < activations->rows; example++) {
+			for (int column = 0; column < activations->columns; column++) {
+				double activation = nn_Matrix_get(activations, example, column);
+				if (layer == network->numberOfLayers - 1) {
+					// derivative of cost times derivative of sigmoid
+					double desiredOutput = nn_Matrix_get(trainingDataOutputs, example, column);
+					nn_Matrix_set(deltas, example, column, 2 * (desiredOutput - activation) * activation * (1 - activation));
+				}
+				else {
+					double sum = 0.0;
+					for (int previousDeltaColumn = 0; previousDeltaColumn < previousDeltas->columns; previousDeltaColumn++) {
+						sum += nn_Matrix_get(previousDeltas, example, previousDeltaColumn) *
+								nn_Matrix_get(network->layerWeights[layer + 1], column, previousDeltaColumn);
+					}
+					nn_Matrix_set(deltas, example, column, sum * activation * (1 - activation));
+				}
+			}
+		}
+		nn_Matrix *weights = network->layerWeights[layer];
+		layerUpdates[layer] = nn_Matrix_alloc(weights->rows, weights->columns);
+		for (int weightRow = 0; weightRow < weights->rows; weightRow++) {
+			for (int weightColumn = 0; weightColumn < weights->columns; weightColumn++) {
+				double weightTotal = 0.0;
+				for (int example = 0; example < deltas->rows; example++) {
+					weightTotal += nn_Matrix_get(deltas, example, weightColumn) *
+							nn_Matrix_get(layerActivations[layer - 1], example, weightRow);
+				}
+				nn_Matrix_set(layerUpdates[layer], weightRow, weightColumn, weightTotal / deltas->rows);
+			}
+		}
+		if (previousDeltas != NULL) {
+			nn_Matrix_free(previousDeltas);
+		}
+		previousDeltas = deltas;
+	}
+	nn_Matrix_free(previousDeltas);
+
+	for (int layer = 1; layer < network->numberOfLayers; layer++) {
+		nn_Matrix *weights = network->layerWeights[layer];
+		for (int weight = 0; weight < weights->rows * weights->columns; weight++) {
+			weights->data[weight] += layerUpdates[layer]->data[weight] * trainingIncrement;
+		}
+		nn_Matrix_free(layerUpdates[layer]);
+		nn_Matrix_free(layerActivations[layer]);
+	}
+	free(layerUpdates);
+	free(layerActivations);
+	int numberOfOutputValues = outputs->rows * outputs->columns;
+	nn_Matrix_free(outputs);
+	return totalCost / numberOfOutputValues;
+}
+
+double nn_DifferentialTest__sigmoid(double input) {
+	return 1 / (1 + exp(0 - input));
+}
+
+// 2 to 5 layers of 1 to 40 nodes, with weights from one of a few distributions: small, wide (saturating the
+// sigmoid), tiny, or mostly zeros (like a pruned network).
+nn_Network *nn_DifferentialTest__allocRandomNetwork(unsigned long long *state) {
+	char layout[64];
+	int numberOfLayers = 2 + (int)(nn_Network_random(state) * 4);
+	int length = 0;
+	for (int l = 0; l < numberOfLayers; l++) {
+		length += sprintf(layout + length, l == 0 ? "%d" : ", %d", 1 + (int)(nn_Network_random(state) * 40));
+	}
+	nn_Network *network = nn_Network_alloc(layout);
+
+	int distribution = (int)(nn_Network_random(state) * 4);
+	double ranges[] = { 1.0, 10.0, 1e-3, 3.0 };
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		nn_Matrix *weights = network->layerWeights[l];
+		for (int i = 0; i < weights->rows * weights->columns; i++) {
+			weights->data[i] = (nn_Network_random(state) * 2.0 - 1.0) * ranges[distribution];
+			if (distribution == 3 && nn_Network_random(state) < 0.7) {
+				weights->data[i] = 0.0;
+			}
+		}
+	}
+	return network;
+}
+
+// Mixes 0s and 1s (like one-hot inputs) with values between -1 and 1.
+void nn_DifferentialTest__fillRandomInputs(nn_Matrix *matrix, unsigned long long *state) {
+	bool isBinary = nn_Network_random(state) < 0.5;
+	for (int i = 0; i < matrix->rows * matrix->columns; i++) {
+		matrix->data[i] = isBinary ? (double)(nn_Network_random(state) < 0.3) : nn_Network_random(state) * 2.0 - 1.0;
+	}
+}
+
+// Number of representable doubles between `a` and `b`.
+int64_t nn_DifferentialTest__ulps(double a, double b) {
+	int64_t aBits, bBits;
+	memcpy(&aBits, &a, sizeof(double));
+	memcpy(&bBits, &b, sizeof(double));
+	// make the ordering of negative numbers continuous with the positive ones
+	if (aBits < 0) {
+		aBits = INT64_MIN - aBits;
+	}
+	if (bBits < 0) {
+		bBits = INT64_MIN - bBits;
+	}
+	return llabs(aBits - bBits);
+}
+
+// Within NN_DIFFERENTIAL_MAX_ULPS, or `maxRelativeError` of the larger of the two (and at least 1, because values
+// that cancel out to nearly 0 can't be compared relatively).
+bool nn_DifferentialTest__isClose(double a, double b, double maxRelativeError) {
+	if (isnan(a) || isnan(b)) {
+		return false;
+	}
+	if (nn_DifferentialTest__ulps(a, b) <= NN_DIFFERENTIAL_MAX_ULPS) {
+		return true;
+	}
+	return fabs(a - b) <= maxRelativeError * fmax(1.0, fmax(fabs(a), fabs(b)));
+}
+
+bool nn_DifferentialTest__matricesAreClose(nn_Matrix *a, nn_Matrix *b, double maxRelativeError) {
+	if (a->rows != b->rows || a->columns != b->columns) {
+		return false;
+	}
+	for (int i = 0; i < a->rows * a->columns; i++) {
+		if (!nn_DifferentialTest__isClose(a->data[i], b->data[i], maxRelativeError)) {
+			fprintf(stderr, "Values at row %d, column %d are %.17g and %.17g.\n", i / a->columns, i % a->columns, a->data[i], b->data[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool nn_DifferentialTest__weightsAreClose(nn_Network *a, nn_Network *b, double maxRelativeError) {
+	for (int l = 1; l < a->numberOfLayers; l++) {
+		if (!nn_DifferentialTest__matricesAreClose(a->layerWeights[l], b->layerWeights[l], maxRelativeError)) {
+			fprintf(stderr, "Weights at layer %d differ.\n", l);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,294 @@
+#include <stdlib.h>	// malloc, realloc, free
+#include <string.h>	// memcpy
+#include <stdbool.h>	// bool, true, false
+#include <math.h>	// exp
+
+#include "nn_Expression.h"
+
+// Expressions are built as a list of nodes, where each node's operands come before it, so the list is already in
+// postfix order. Evaluating compiles the nodes that the results need into a program, then runs the whole program
+// over one chunk of values at a time. Each operation is a tight loop over a chunk, which the compiler can vectorise,
+// and a chunk of every intermediate value fits in cache, so the matrices are only read (and written) once.
+
+#define NN_EXPRESSION_CHUNK_SIZE	256
+#define NN_EXPRESSION_INITIAL_CAPACITY	8
+
+// 'private' functions
+int nn_Expression__addNode(nn_Expression *this, int operation, int a, int b);
+void nn_Expression__addResult(nn_Expression *this, int node, nn_Matrix *matrix, double *sum);
+int nn_Expression__compile(nn_Expression *this, int *program);
+bool nn_Expression__hasSameSize(nn_Matrix *matrix, nn_Matrix **sizedMatrix);
+void nn_Expression__calculate(int operation, double *values, double *a, double *b, int count);
+
+nn_Expression *nn_Expression_alloc() {
+	nn_Expression *this = malloc(sizeof(nn_Expression));
+	this->numberOfNodes = 0;
+	this->nodesCapacity = NN_EXPRESSION_INITIAL_CAPACITY;
+	this->nodes = malloc(sizeof(nn_ExpressionNode) * this->nodesCapacity);
+	this->numberOfResults = 0;
+	this->resultsCapacity = NN_EXPRESSION_INITIAL_CAPACITY;
+	this->results = malloc(sizeof(nn_ExpressionResult) * this->resultsCapacity);
+	return this;
+}
+
+// Doesn't free the matrices, they still belong to the caller.
+void nn_Expression_free(nn_Expression *this) {
+	free(this->nodes);
+	free(this->results);
+	free(this);
+}
+
+int nn_Expression_matrix(nn_Expression *this, nn_Matrix *matrix) {
+	int node = nn_Expression__addNode(this, NN_EXPRESSION_MATRIX, -1, -1);
+	this->nodes[node].matrix = matrix;
+	return node;
+}
+
+int nn_Expression_constant(nn_Expression *this, double constant) {
+	int node = nn_Expression__addNode(this, NN_EXPRESSION_CONSTANT, -1, -1);
+	this->nodes[node].constant = constant;
+	return node;
+}
+
+int nn_Expression_add(nn_Expression *this, int a, int b) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_ADD, a, b);
+}
+
+// a - b
+int nn_Expression_subtract(nn_Expression *this, int a, int b) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_SUBTRACT, a, b);
+}
+
+int nn_Expression_multiply(nn_Expression *this, int a, int b) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_MULTIPLY, a, b);
+}
+
+int nn_Expression_square(nn_Expression *this, int a) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_SQUARE, a, -1);
+}
+
+int nn_Expression_sigmoid(nn_Expression *this, int a) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_SIGMOID, a, -1);
+}
+
+int nn_Expression_derivativeOfSigmoid(nn_Expression *this, int a) {
+	return nn_Expression__addNode(this, NN_EXPRESSION_DERIVATIVE_OF_SIGMOID, a, -1);
+}
+
+// When evaluated, `matrix` is filled with the values of `node`. It can be one of the expression's own matrices,
+// e.g. to add to a matrix in place, because every node is calculated for a chunk before any of the chunk is stored.
+// A result that's just one of the matrices is read at the time it's stored though, so when that matrix is also
+// stored into, its chunk is copied before any of the results are stored.
+void nn_Expression_storeInMatrix(nn_Expression *this, int node, nn_Matrix *matrix) {
+	nn_Expression__addResult(this, node, matrix, NULL);
+}
+
+// When evaluated, `sum` is set to the total of the values of `node`, added up in order.
+void nn_Expression_storeSum(nn_Expression *this, int node, double *sum) {
+	nn_Expression__addResult(this, node, NULL, sum);
+}
+
+// Calculates every result in one pass. Can be called again, e.g. after the matrices' values have changed.
+// Returns 0 on success, or NN_ERROR_EXPRESSION_SIZES (without changing any results) if the matrices that are
+// read or stored into don't all have the same rows and columns.
+int nn_Expression_evaluate(nn_Expression *this) {
+	// One allocation for the program, and which matrices need copying
+	int *program = malloc(sizeof(int) * 2 * this->numberOfNodes);
+	int *isCopied = program + this->numberOfNodes;
+	int programLength = nn_Expression__compile(this, program);
+
+	// the number of values comes from the matrices, which all have the same size
+	nn_Matrix *sizedMatrix = NULL;
+	for (int r = 0; r < this->numberOfResults; r++) {
+		if (!nn_Expression__hasSameSize(this->results[r].matrix, &sizedMatrix)) {
+			free(program);
+			return NN_ERROR_EXPRESSION_SIZES;
+		}
+	}
+	for (int i = 0; i < programLength; i++) {
+		if (this->nodes[program[i]].operation == NN_EXPRESSION_MATRIX &&
+				!nn_Expression__hasSameSize(this->nodes[program[i]].matrix, &sizedMatrix)) {
+			free(program);
+			return NN_ERROR_EXPRESSION_SIZES;
+		}
+	}
+	for (int r = 0; r < this->numberOfResults; r++) {
+		if (this->results[r].matrix == NULL) {
+			*this->results[r].sum = 0.0;
+		}
+	}
+	int numberOfValues = sizedMatrix != NULL ? sizedMatrix->rows * sizedMatrix->columns : 0;
+	int chunkSize = numberOfValues < NN_EXPRESSION_CHUNK_SIZE ? numberOfValues : NN_EXPRESSION_CHUNK_SIZE;
+
+	// One allocation for a chunk of values for each node, and pointers to each node's values for the current chunk
+	// (matrices point straight at their data)
+	char *memory = malloc((sizeof(double) * chunkSize + sizeof(double *)) * this->numberOfNodes);
+	double *buffers = (double *)memory;
+	double **values = (double **)(memory + sizeof(double) * chunkSize * this->numberOfNodes);
+
+	// Matrices that are a result themselves, and are also stored into by a result, would be read after (maybe)
+	// being overwritten, so their values are copied first
+	for (int n = 0; n < this->numberOfNodes; n++) {
+		isCopied[n] = false;
+	}
+	for (int r = 0; r < this->numberOfResults; r++) {
+		nn_ExpressionNode *node = &this->nodes[this->results[r].node];
+		for (int stored = 0; node->operation == NN_EXPRESSION_MATRIX && stored < this->numberOfResults; stored++) {
+			if (this->results[stored].matrix == node->matrix) {
+				isCopied[this->results[r].node] = true;
+			}
+		}
+	}
+
+	// constants are the same for every chunk, so they're filled in once
+	for (int i = 0; i < programLength; i++) {
+		nn_ExpressionNode *node = &this->nodes[program[i]];
+		values[program[i]] = &buffers[program[i] * chunkSize];
+		if (node->operation == NN_EXPRESSION_CONSTANT) {
+			for (int v = 0; v < chunkSize; v++) {
+				values[program[i]][v] = node->constant;
+			}
+		}
+	}
+
+	for (int start = 0; start < numberOfValues; start += chunkSize) {
+		int count = numberOfValues - start < chunkSize ? numberOfValues - start : chunkSize;
+		for (int i = 0; i < programLength; i++) {
+			nn_ExpressionNode *node = &this->nodes[program[i]];
+			if (node->operation == NN_EXPRESSION_MATRIX && isCopied[program[i]]) {
+				memcpy(values[program[i]], &node->matrix->data[start], sizeof(double) * count);
+			}
+			else if (node->operation == NN_EXPRESSION_MATRIX) {
+				values[program[i]] = &node->matrix->data[start];
+			}
+			else if (node->operation != NN_EXPRESSION_CONSTANT) {
+				nn_Expression__calculate(node->operation, values[program[i]], values[node->a],
+						node->b >= 0 ? values[node->b] : NULL, count);
+			}
+		}
+		for (int r = 0; r < this->numberOfResults; r++) {
+			nn_ExpressionResult *result = &this->results[r];
+			double *resultValues = values[result->node];
+			if (result->matrix != NULL) {
+				if (resultValues != &result->matrix->data[start]) {
+					memcpy(&result->matrix->data[start], resultValues, sizeof(double) * count);
+				}
+			}
+			else {
+				double sum = *result->sum;
+				for (int v = 0; v < count; v++) {
+					sum += resultValues[v];
+				}
+				*result->sum = sum;
+			}
+		}
+	}
+
+	free(memory);
+	free(program);
+	return 0;
+}
+
+int nn_Expression__addNode(nn_Expression *this, int operation, int a, int b) {
+	if (this->numberOfNodes == this->nodesCapacity) {
+		this->nodesCapacity *= 2;
+		this->nodes = realloc(this->nodes, sizeof(nn_ExpressionNode) * this->nodesCapacity);
+	}
+	nn_ExpressionNode *node = &this->nodes[this->numberOfNodes];
+	node->operation = operation;
+	node->a = a;
+	node->b = b;
+	node->matrix = NULL;
+	node->constant = 0.0;
+	return this->numberOfNodes++;
+}
+
+void nn_Expression__addResult(nn_Expression *this, int node, nn_Matrix *matrix, double *sum) {
+	if (this->numberOfResults == this->resultsCapacity) {
+		this->resultsCapacity *= 2;
+		this->results = realloc(this->results, sizeof(nn_ExpressionResult) * this->resultsCapacity);
+	}
+	nn_ExpressionResult *result = &this->results[this->numberOfResults++];
+	result->node = node;
+	result->matrix = matrix;
+	result->sum = sum;
+}
+
+// Fills `program` (which needs room for every node) with the nodes needed for the results, in order, and returns
+// how many there are. Nodes that no result uses are left out. Operands always come before the nodes that use them,
+// so going backwards through the nodes finds everything that's needed in one go.
+int nn_Expression__compile(nn_Expression *this, int *program) {
+	// first `program` marks which nodes are needed
+	for (int n = 0; n < this->numberOfNodes; n++) {
+		program[n] = false;
+	}
+	for (int r = 0; r < this->numberOfResults; r++) {
+		program[this->results[r].node] = true;
+	}
+	for (int n = this->numberOfNodes - 1; n >= 0; n--) {
+		if (program[n]) {
+			if (this->nodes[n].a >= 0) {
+				program[this->nodes[n].a] = true;
+			}
+			if (this->nodes[n].b >= 0) {
+				program[this->nodes[n].b] = true;
+			}
+		}
+	}
+	// then the needed nodes are moved to the front (never past a mark that hasn't been read yet)
+	int programLength = 0;
+	for (int n = 0; n < this->numberOfNodes; n++) {
+		if (program[n]) {
+			program[programLength++] = n;
+		}
+	}
+	return programLength;
+}
+
+// Whether `matrix` has the same rows and columns as `sizedMatrix`, which is set to `matrix` if it's the first.
+// NULL matrices (i.e. sums) have any size.
+bool nn_Expression__hasSameSize(nn_Matrix *matrix, nn_Matrix **sizedMatrix) {
+	if (matrix == NULL) {
+		return true;
+	}
+	if (*sizedMatrix == NULL) {
+		*sizedMatrix = matrix;
+	}
+	return matrix->rows == (*sizedMatrix)->rows && matrix->columns == (*sizedMatrix)->columns;
+}
+
+// One operation over a chunk, `b` is NULL for operations with one operand.
+void nn_Expression__calculate(int operation, double *values, double *a, double *b, int count) {
+	switch (operation) {
+		case NN_EXPRESSION_ADD:
+			for (int v = 0; v < count; v++) {
+				values[v] = a[v] + b[v];
+			}
+			break;
+		case NN_EXPRESSION_SUBTRACT:
+			for (int v = 0; v < count; v++) {
+				values[v] = a[v] - b[v];
+			}
+			break;
+		case NN_EXPRESSION_MULTIPLY:
+			for (int v = 0; v < count; v++) {
+				values[v] = a[v] * b[v];
+			}
+			break;
+		case NN_EXPRESSION_SQUARE:
+			for (int v = 0; v < count; v++) {
+				values[v] = a[v] * a[v];
+			}
+			break;
+		case NN_EXPRESSION_SIGMOID:
+			for (int v = 0; v < count; v++) {
+				values[v] = 1 / (1 + exp(0 - a[v]));
+			}
+			break;
+		case NN_EXPRESSION_DERIVATIVE_OF_SIGMOID:
+			for (int v = 0; v < count; v++) {
+				values[v] = a[v] * (1 - a[v]);
+			}
+			break;
+	}
+}
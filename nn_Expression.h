@@ -0,0 +1,63 @@
+#ifndef __NN_EXPRESSION_H__
+#define __NN_EXPRESSION_H__
+
+
+#include "nn_Matrix.h"
+
+// Operations at each node of an expression
+#define NN_EXPRESSION_MATRIX	0
+#define NN_EXPRESSION_CONSTANT	1
+#define NN_EXPRESSION_ADD	2
+#define NN_EXPRESSION_SUBTRACT	3
+#define NN_EXPRESSION_MULTIPLY	4
+#define NN_EXPRESSION_SQUARE	5
+#define NN_EXPRESSION_SIGMOID	6
+#define NN_EXPRESSION_DERIVATIVE_OF_SIGMOID	7	// s * (1 - s), where s is already the output of a sigmoid
+
+#define NN_ERROR_EXPRESSION_SIZES	6
+
+typedef struct {
+	int operation;
+	int a;	// operands (indexes of earlier nodes), -1 if not used
+	int b;
+	nn_Matrix *matrix;	// for NN_EXPRESSION_MATRIX
+	double constant;	// for NN_EXPRESSION_CONSTANT
+} nn_ExpressionNode;
+
+// What's wanted from evaluating, either a node's values stored in a matrix, or the sum of a node's values
+typedef struct {
+	int node;
+	nn_Matrix *matrix;	// NULL for a sum
+	double *sum;
+} nn_ExpressionResult;
+
+// Elementwise operations on matrices, which are only calculated when the expression is evaluated, in one pass
+// over memory for all of the results together. Every matrix must have the same rows and columns.
+typedef struct {
+	int numberOfNodes;
+	int nodesCapacity;
+	nn_ExpressionNode *nodes;
+	int numberOfResults;
+	int resultsCapacity;
+	nn_ExpressionResult *results;
+} nn_Expression;
+
+nn_Expression *nn_Expression_alloc();
+void nn_Expression_free(nn_Expression *this);
+
+// Each of these adds a node and returns its index, to be used as an operand of later nodes
+int nn_Expression_matrix(nn_Expression *this, nn_Matrix *matrix);
+int nn_Expression_constant(nn_Expression *this, double constant);
+int nn_Expression_add(nn_Expression *this, int a, int b);
+int nn_Expression_subtract(nn_Expression *this, int a, int b);
+int nn_Expression_multiply(nn_Expression *this, int a, int b);
+int nn_Expression_square(nn_Expression *this, int a);
+int nn_Expression_sigmoid(nn_Expression *this, int a);
+int nn_Expression_derivativeOfSigmoid(nn_Expression *this, int a);
+
+void nn_Expression_storeInMatrix(nn_Expression *this, int node, nn_Matrix *matrix);
+void nn_Expression_storeSum(nn_Expression *this, int node, double *sum);
+int nn_Expression_evaluate(nn_Expression *this);
+
+
+#endif
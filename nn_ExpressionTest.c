@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "nn_Expression.h"
+
+int main() {
+	// Test nn_Expression_evaluate, scenario: each operation
+	{
+		nn_Matrix *a = nn_Matrix_allocWithValues(2, 2,
+			0.0, 1.0,
+			-2.0, 0.5
+		);
+		nn_Matrix *b = nn_Matrix_allocWithValues(2, 2,
+			3.0, 2.0,
+			1.0, 0.25
+		);
+		nn_Matrix *sums = nn_Matrix_alloc(2, 2);
+		nn_Matrix *differences = nn_Matrix_alloc(2, 2);
+		nn_Matrix *products = nn_Matrix_alloc(2, 2);
+		nn_Matrix *squares = nn_Matrix_alloc(2, 2);
+		nn_Matrix *sigmoids = nn_Matrix_alloc(2, 2);
+		nn_Matrix *derivatives = nn_Matrix_alloc(2, 2);
+		nn_Matrix *scaled = nn_Matrix_alloc(2, 2);
+		nn_Expression *expression = nn_Expression_alloc();
+		int aNode = nn_Expression_matrix(expression, a);
+		int bNode = nn_Expression_matrix(expression, b);
+		nn_Expression_storeInMatrix(expression, nn_Expression_add(expression, aNode, bNode), sums);
+		nn_Expression_storeInMatrix(expression, nn_Expression_subtract(expression, aNode, bNode), differences);
+		nn_Expression_storeInMatrix(expression, nn_Expression_multiply(expression, aNode, bNode), products);
+		nn_Expression_storeInMatrix(expression, nn_Expression_square(expression, aNode), squares);
+		nn_Expression_storeInMatrix(expression, nn_Expression_sigmoid(expression, aNode), sigmoids);
+		nn_Expression_storeInMatrix(expression, nn_Expression_derivativeOfSigmoid(expression, bNode), derivatives);
+		nn_Expression_storeInMatrix(expression, nn_Expression_multiply(expression, aNode, nn_Expression_constant(expression, 3.0)), scaled);
+		nn_Expression_evaluate(expression);
+		for (int i = 0; i < 4; i++) {
+			assert(sums->data[i] == a->data[i] + b->data[i]);
+			assert(differences->data[i] == a->data[i] - b->data[i]);
+			assert(products->data[i] == a->data[i] * b->data[i]);
+			assert(squares->data[i] == a->data[i] * a->data[i]);
+			assert(sigmoids->data[i] == 1 / (1 + exp(0 - a->data[i])));
+			assert(derivatives->data[i] == b->data[i] * (1 - b->data[i]));
+			assert(scaled->data[i] == a->data[i] * 3.0);
+		}
+		assert(nn_Matrix_get(sigmoids, 0, 0) == 0.5);
+		assert(nn_Matrix_get(derivatives, 0, 0) == -6.0);
+		nn_Expression_free(expression);
+		nn_Matrix_free(a);
+		nn_Matrix_free(b);
+		nn_Matrix_free(sums);
+		nn_Matrix_free(differences);
+		nn_Matrix_free(products);
+		nn_Matrix_free(squares);
+		nn_Matrix_free(sigmoids);
+		nn_Matrix_free(derivatives);
+		nn_Matrix_free(scaled);
+	}
+
+	// Test nn_Expression_evaluate, scenario: a matrix and a sum from the same pass, over more than one chunk,
+	// the same as separate loops
+	{
+		nn_Matrix *outputs = nn_Matrix_alloc(100, 7);
+		nn_Matrix *desiredOutputs = nn_Matrix_alloc(100, 7);
+		for (int i = 0; i < 700; i++) {
+			outputs->data[i] = (i % 13) / 13.0;
+			desiredOutputs->data[i] = (i % 3) / 2.0;
+		}
+		nn_Matrix *deltas = nn_Matrix_alloc(100, 7);
+		nn_Expression *expression = nn_Expression_alloc();
+		int computed = nn_Expression_matrix(expression, outputs);
+		int error = nn_Expression_subtract(expression, nn_Expression_matrix(expression, desiredOutputs), computed);
+		nn_Expression_storeInMatrix(expression,
+				nn_Expression_multiply(expression, error, nn_Expression_derivativeOfSigmoid(expression, computed)), deltas);
+		double totalCost;
+		nn_Expression_storeSum(expression, nn_Expression_square(expression, error), &totalCost);
+		nn_Expression_evaluate(expression);
+
+		double expectedTotalCost = 0.0;
+		for (int i = 0; i < 700; i++) {
+			double expectedError = desiredOutputs->data[i] - outputs->data[i];
+			expectedTotalCost += expectedError * expectedError;
+			assert(deltas->data[i] == expectedError * (outputs->data[i] * (1 - outputs->data[i])));
+		}
+		assert(totalCost == expectedTotalCost);
+
+		// evaluating again uses the matrices' new values, and starts the sum again
+		for (int i = 0; i < 700; i++) {
+			desiredOutputs->data[i] = outputs->data[i];
+		}
+		nn_Expression_evaluate(expression);
+		assert(totalCost == 0.0);
+		assert(deltas->data[699] == 0.0);
+
+		nn_Expression_free(expression);
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(desiredOutputs);
+		nn_Matrix_free(deltas);
+	}
+
+	// Test nn_Expression_storeInMatrix, scenario: in place, into one of the expression's own matrices
+	{
+		nn_Matrix *weights = nn_Matrix_alloc(30, 30);
+		nn_Matrix *updates = nn_Matrix_alloc(30, 30);
+		for (int i = 0; i < 900; i++) {
+			weights->data[i] = i;
+			updates->data[i] = 900 - i;
+		}
+		nn_Expression *expression = nn_Expression_alloc();
+		int scaledUpdates = nn_Expression_multiply(expression, nn_Expression_matrix(expression, updates),
+				nn_Expression_constant(expression, 0.5));
+		nn_Expression_storeInMatrix(expression, nn_Expression_add(expression, nn_Expression_matrix(expression, weights), scaledUpdates),
+				weights);
+		nn_Expression_evaluate(expression);
+		for (int i = 0; i < 900; i++) {
+			assert(weights->data[i] == i + (900 - i) * 0.5);
+		}
+		nn_Expression_free(expression);
+		nn_Matrix_free(weights);
+		nn_Matrix_free(updates);
+	}
+
+	// Test nn_Expression_storeInMatrix, scenario: a later result is just a matrix that an earlier result stored into
+	{
+		nn_Matrix *a = nn_Matrix_alloc(20, 20);
+		nn_Matrix *b = nn_Matrix_alloc(20, 20);
+		for (int i = 0; i < 400; i++) {
+			a->data[i] = i;
+			b->data[i] = -i;
+		}
+		nn_Expression *expression = nn_Expression_alloc();
+		int aNode = nn_Expression_matrix(expression, a);
+		int bNode = nn_Expression_matrix(expression, b);
+		// swaps a and b, and adds up a's values from before
+		nn_Expression_storeInMatrix(expression, bNode, a);
+		nn_Expression_storeInMatrix(expression, aNode, b);
+		double sum;
+		nn_Expression_storeSum(expression, aNode, &sum);
+		nn_Expression_evaluate(expression);
+		for (int i = 0; i < 400; i++) {
+			assert(a->data[i] == -i);
+			assert(b->data[i] == i);
+		}
+		assert(sum == 399 * 400 / 2);
+		nn_Expression_free(expression);
+		nn_Matrix_free(a);
+		nn_Matrix_free(b);
+	}
+
+	// Test nn_Expression_evaluate, scenario: nodes that no result uses aren't calculated
+	{
+		nn_Matrix *a = nn_Matrix_allocWithValues(1, 2, 1.0, 2.0);
+		nn_Matrix *b = nn_Matrix_allocWithValues(1, 1, 5.0);	// wrong size, but never read
+		nn_Matrix *result = nn_Matrix_alloc(1, 2);
+		nn_Expression *expression = nn_Expression_alloc();
+		int aNode = nn_Expression_matrix(expression, a);
+		nn_Expression_add(expression, aNode, nn_Expression_matrix(expression, b));
+		nn_Expression_storeInMatrix(expression, nn_Expression_square(expression, aNode), result);
+		nn_Expression_evaluate(expression);
+		assert(nn_Matrix_get(result, 0, 0) == 1.0);
+		assert(nn_Matrix_get(result, 0, 1) == 4.0);
+		nn_Expression_free(expression);
+		nn_Matrix_free(a);
+		nn_Matrix_free(b);
+		nn_Matrix_free(result);
+	}
+
+	// Test nn_Expression_evaluate, scenario: matrices of different sizes, nothing is changed
+	{
+		nn_Matrix *a = nn_Matrix_allocWithValues(2, 3, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0);
+		nn_Matrix *transposed = nn_Matrix_alloc(3, 2);
+		nn_Matrix *result = nn_Matrix_alloc(2, 3);
+		nn_Matrix_fillWithZeros(result);
+
+		// an operand
+		nn_Expression *expression = nn_Expression_alloc();
+		int sum = nn_Expression_add(expression, nn_Expression_matrix(expression, a), nn_Expression_matrix(expression, transposed));
+		nn_Expression_storeInMatrix(expression, sum, result);
+		double total = -1.0;
+		nn_Expression_storeSum(expression, sum, &total);
+		assert(nn_Expression_evaluate(expression) == NN_ERROR_EXPRESSION_SIZES);
+		assert(total == -1.0);
+		assert(nn_Matrix_get(result, 1, 2) == 0.0);
+		nn_Expression_free(expression);
+
+		// a result
+		expression = nn_Expression_alloc();
+		nn_Expression_storeInMatrix(expression, nn_Expression_square(expression, nn_Expression_matrix(expression, a)), transposed);
+		assert(nn_Expression_evaluate(expression) == NN_ERROR_EXPRESSION_SIZES);
+		nn_Expression_free(expression);
+
+		// the same sizes
+		expression = nn_Expression_alloc();
+		nn_Expression_storeInMatrix(expression, nn_Expression_square(expression, nn_Expression_matrix(expression, a)), result);
+		assert(nn_Expression_evaluate(expression) == 0);
+		assert(nn_Matrix_get(result, 1, 2) == 36.0);
+		nn_Expression_free(expression);
+
+		nn_Matrix_free(a);
+		nn_Matrix_free(transposed);
+		nn_Matrix_free(result);
+	}
+
+	return 0;
+}
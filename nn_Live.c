@@ -0,0 +1,85 @@
+#include <stdlib.h>	// malloc, free
+#include <sched.h>	// sched_yield
+
+#include "nn_Live.h"
+
+// Online learning while serving inference. The training thread calls nn_Live_train as new examples arrive
+// and nn_Live_publish whenever the new weights should be used, e.g. every hour.
+// Inference never takes a lock or waits for training. There are two published copies of the weights: readers
+// use the latest one, and nn_Live_publish writes into the other one. Each copy has a count of the threads using
+// it, and publishing waits for any readers still using the older copy to finish before overwriting it, so a
+// reader always sees one whole version of the weights.
+
+// 'private' functions
+int nn_Live__startReading(nn_Live *this);
+
+// Copies `network`, which isn't used after this returns. Version 0 is the weights of `network`.
+nn_Live *nn_Live_alloc(nn_Network *network) {
+	nn_Live *this = malloc(sizeof(nn_Live));
+	this->trainingNetwork = nn_Network_allocCopy(network);
+	for (int i = 0; i < 2; i++) {
+		this->publishedNetworks[i] = nn_Network_allocCopy(network);
+		atomic_init(&this->readers[i], 0);
+		this->versions[i] = 0;
+	}
+	atomic_init(&this->current, 0);
+	this->version = 0;
+	return this;
+}
+
+// No other threads can be using it.
+void nn_Live_free(nn_Live *this) {
+	nn_Network_free(this->trainingNetwork);
+	nn_Network_free(this->publishedNetworks[0]);
+	nn_Network_free(this->publishedNetworks[1]);
+	free(this);
+}
+
+// Same as nn_Network_train on the private copy, inference doesn't see the changes until nn_Live_publish.
+// Only call from the training thread.
+double nn_Live_train(nn_Live *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, double trainingIncrement) {
+	return nn_Network_train(this->trainingNetwork, trainingDataInputs, trainingDataOutputs, trainingIncrement);
+}
+
+// Makes the current weights of trainingNetwork the ones used for inference, and returns the new version number.
+// Only call from the training thread.
+int nn_Live_publish(nn_Live *this) {
+	int next = 1 - atomic_load(&this->current);
+	// wait for readers that started before the last publish to finish with the older copy
+	while (atomic_load(&this->readers[next]) > 0) {
+		sched_yield();
+	}
+	nn_Network_copyWeightsFromNetwork(this->publishedNetworks[next], this->trainingNetwork);
+	this->version++;
+	this->versions[next] = this->version;
+	atomic_store(&this->current, next);
+	return this->version;
+}
+
+// Returns a new matrix with the outputs from the latest published weights, which the caller needs to free.
+// Safe to call from any number of threads at once, and while training. If `version` isn't NULL it's set to
+// the version of the weights that were used.
+nn_Matrix *nn_Live_inference(nn_Live *this, nn_Matrix *inputs, int *version) {
+	int i = nn_Live__startReading(this);
+	nn_Matrix *outputs = nn_Network_allocInference(this->publishedNetworks[i], inputs);
+	if (version != NULL) {
+		*version = this->versions[i];
+	}
+	atomic_fetch_sub(&this->readers[i], 1);
+	return outputs;
+}
+
+// Registers as a reader of the latest published copy, and returns its index.
+int nn_Live__startReading(nn_Live *this) {
+	while (1) {
+		int i = atomic_load(&this->current);
+		atomic_fetch_add(&this->readers[i], 1);
+		// If a publish happened in between, the writer may not have seen this reader before it started
+		// overwriting this copy, so try again with the newer one. Otherwise the copy can't be overwritten
+		// until this reader has finished (all of these are sequentially consistent).
+		if (atomic_load(&this->current) == i) {
+			return i;
+		}
+		atomic_fetch_sub(&this->readers[i], 1);
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef __NN_LIVE_H__
+#define __NN_LIVE_H__
+
+
+#include <stdatomic.h>	// atomic_int
+
+#include "nn_Network.h"
+
+// A network that keeps training while other threads use it for inference. Training changes a private copy,
+// and nn_Live_publish copies its weights into whichever of the two published copies isn't in use.
+typedef struct {
+	nn_Network *trainingNetwork;	// only used by the training thread
+	nn_Network *publishedNetworks[2];
+	atomic_int current;	// index into publishedNetworks of the latest version
+	atomic_int readers[2];	// number of threads doing inference with each published copy
+	int versions[2];	// version of each published copy
+	int version;	// latest published version, only changed by the training thread
+} nn_Live;
+
+nn_Live *nn_Live_alloc(nn_Network *network);
+void nn_Live_free(nn_Live *this);
+
+double nn_Live_train(nn_Live *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, double trainingIncrement);
+int nn_Live_publish(nn_Live *this);
+nn_Matrix *nn_Live_inference(nn_Live *this, nn_Matrix *inputs, int *version);
+
+
+#endif
@@ -0,0 +1,139 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "nn_Live.h"
+
+#define NUMBER_OF_VERSIONS	200
+#define NUMBER_OF_READERS	3
+
+// outputs for each version of the weights in the concurrent test
+double expectedOutputs[NUMBER_OF_VERSIONS + 1];
+atomic_bool finished;
+
+void setAllWeights(nn_Network *network, double value) {
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+			network->layerWeights[l]->data[w] = value;
+		}
+	}
+}
+
+void *readOutputs(void *live) {
+	nn_Matrix *inputs = nn_Matrix_allocWithValues(1, 2, 1.0, 0.5);
+	int lastVersion = 0;
+	while (!atomic_load(&finished)) {
+		int version;
+		nn_Matrix *outputs = nn_Live_inference(live, inputs, &version);
+		// every weight is from the same version, and versions only go forwards
+		assert(nn_Matrix_get(outputs, 0, 0) == expectedOutputs[version]);
+		assert(version >= lastVersion);
+		lastVersion = version;
+		nn_Matrix_free(outputs);
+	}
+	nn_Matrix_free(inputs);
+	return NULL;
+}
+
+int main() {
+	nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+		0.0, 0.0,
+		0.0, 1.0,
+		1.0, 0.0,
+		1.0, 1.0
+	);
+	nn_Matrix *outputs = nn_Matrix_allocWithValues(4, 1,
+		1.0,
+		0.0,
+		0.0,
+		1.0
+	);
+
+	// Test nn_Live_train, scenario: inference only changes after publishing
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -3.0, 3.0, 1);
+		nn_Live *live = nn_Live_alloc(network);
+
+		int version;
+		nn_Matrix *before = nn_Live_inference(live, inputs, &version);
+		assert(version == 0);
+		nn_Matrix *expected = nn_Network_allocInference(network, inputs);
+		for (int i = 0; i < 4; i++) {
+			assert(before->data[i] == expected->data[i]);
+		}
+		nn_Matrix_free(expected);
+
+		for (int step = 0; step < 10; step++) {
+			double cost = nn_Live_train(live, inputs, outputs, 1.0);
+			assert(cost == nn_Network_train(network, inputs, outputs, 1.0));
+		}
+		nn_Matrix *unpublished = nn_Live_inference(live, inputs, &version);
+		assert(version == 0);
+		for (int i = 0; i < 4; i++) {
+			assert(unpublished->data[i] == before->data[i]);
+		}
+
+		assert(nn_Live_publish(live) == 1);
+		nn_Matrix *published = nn_Live_inference(live, inputs, &version);
+		assert(version == 1);
+		expected = nn_Network_allocInference(network, inputs);
+		for (int i = 0; i < 4; i++) {
+			assert(published->data[i] == expected->data[i]);
+			assert(published->data[i] != before->data[i]);
+		}
+		nn_Matrix_free(expected);
+
+		// publishing twice uses both copies
+		assert(nn_Live_publish(live) == 2);
+		nn_Matrix *again = nn_Live_inference(live, inputs, &version);
+		assert(version == 2);
+		for (int i = 0; i < 4; i++) {
+			assert(again->data[i] == published->data[i]);
+		}
+
+		nn_Matrix_free(again);
+		nn_Matrix_free(published);
+		nn_Matrix_free(unpublished);
+		nn_Matrix_free(before);
+		nn_Live_free(live);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Live_inference, scenario: readers always see one whole version while new versions are published
+	{
+		nn_Network *network = nn_Network_alloc("2, 8, 8, 1");
+		nn_Matrix *readerInputs = nn_Matrix_allocWithValues(1, 2, 1.0, 0.5);
+		for (int version = 0; version <= NUMBER_OF_VERSIONS; version++) {
+			setAllWeights(network, version / 100.0);
+			nn_Matrix *versionOutputs = nn_Network_allocInference(network, readerInputs);
+			expectedOutputs[version] = nn_Matrix_get(versionOutputs, 0, 0);
+			nn_Matrix_free(versionOutputs);
+		}
+		nn_Matrix_free(readerInputs);
+
+		setAllWeights(network, 0.0);
+		nn_Live *live = nn_Live_alloc(network);
+		atomic_init(&finished, false);
+		pthread_t readers[NUMBER_OF_READERS];
+		for (int r = 0; r < NUMBER_OF_READERS; r++) {
+			pthread_create(&readers[r], NULL, readOutputs, live);
+		}
+		for (int version = 1; version <= NUMBER_OF_VERSIONS; version++) {
+			setAllWeights(live->trainingNetwork, version / 100.0);
+			assert(nn_Live_publish(live) == version);
+		}
+		atomic_store(&finished, true);
+		for (int r = 0; r < NUMBER_OF_READERS; r++) {
+			pthread_join(readers[r], NULL);
+		}
+		nn_Live_free(live);
+		nn_Network_free(network);
+	}
+
+	nn_Matrix_free(inputs);
+	nn_Matrix_free(outputs);
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include <stdlib.h>	// malloc, free
 #include <stdarg.h>	// va_list, va_start, va_arg
 #include <stdio.h>	// printf
+#include <string.h>	// memcpy, memset
 
 #include "nn_Matrix.h"
 
@@ -40,10 +41,17 @@ nn_Matrix *nn_Matrix_allocWithDotProductThenFunctionApplied(nn_Matrix *inputA, n
 }
 
 void nn_Matrix_fillWithDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB, double (*functionToApply)(double)) {
+	nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(this, inputA, inputB, functionToApply, 0, inputB->columns);
+}
+
+// Same as nn_Matrix_fillWithDotProductThenFunctionApplied, but only fills the output columns from `firstColumn`
+// up to (but not including) `endColumn`, so that different threads can fill different columns.
+void nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB,
+		double (*functionToApply)(double), int firstColumn, int endColumn) {
 	// iterate through each row of input A, each one will correspond to a row in the output matrix
 	for (int inputARow = 0; inputARow < inputA->rows; inputARow++) {
 		// calculate the weighted sum for each column at this row, each of these columns will correspond to a column in the output matrix
-		for (int inputBColumn = 0; inputBColumn < inputB->columns; inputBColumn++) {
+		for (int inputBColumn = firstColumn; inputBColumn < endColumn; inputBColumn++) {
 			// accumulate values of each column in input A multiplied by corresponding row of input B
 			double total = 0.0;
 			for (int inputAColumnInputBRow = 0; inputAColumnInputBRow < inputA->columns; inputAColumnInputBRow++) {
@@ -58,6 +66,65 @@ void nn_Matrix_fillWithDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix
 	}
 }
 
+// Same as nn_Matrix_fillColumnsWithDotProductThenFunctionApplied, but goes through input B a row at a
+// time, `blockSize` columns at once, so it reads memory in order and the inner loop can be vectorised. Faster for
+// wide layers, but the best block size depends on the shapes and the CPU (see nn_Plan).
+// Each sum is added up in the same order, but the compiler can fuse multiplies and adds differently in the two
+// loops (e.g. with -march=native), so the results can differ in the last bits.
+void nn_Matrix_fillColumnsWithBlockedDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB,
+		double (*functionToApply)(double), int firstColumn, int endColumn, int blockSize) {
+	for (int inputARow = 0; inputARow < inputA->rows; inputARow++) {
+		double *outputRow = this->data + inputARow * this->columns;
+		for (int firstBlockColumn = firstColumn; firstBlockColumn < endColumn; firstBlockColumn += blockSize) {
+			int endBlockColumn = firstBlockColumn + blockSize < endColumn ? firstBlockColumn + blockSize : endColumn;
+			// accumulate in the output row
+			for (int column = firstBlockColumn; column < endBlockColumn; column++) {
+				outputRow[column] = 0.0;
+			}
+			for (int inputAColumnInputBRow = 0; inputAColumnInputBRow < inputA->columns; inputAColumnInputBRow++) {
+				double inputAValue = inputA->data[inputARow * inputA->columns + inputAColumnInputBRow];
+				double *inputBRow = inputB->data + inputAColumnInputBRow * inputB->columns;
+				for (int column = firstBlockColumn; column < endBlockColumn; column++) {
+					outputRow[column] += inputAValue * inputBRow[column];
+				}
+			}
+			if (functionToApply != NULL) {
+				for (int column = firstBlockColumn; column < endBlockColumn; column++) {
+					outputRow[column] = functionToApply(outputRow[column]);
+				}
+			}
+		}
+	}
+}
+
+// Same as a dot product, but reads input B as if it was transposed, i.e. each row of input A is multiplied
+// by each row of input B. Used to push deltas backwards through a weights matrix.
+void nn_Matrix_fillWithDotProductTransposingB(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB) {
+	for (int inputARow = 0; inputARow < inputA->rows; inputARow++) {
+		for (int inputBRow = 0; inputBRow < inputB->rows; inputBRow++) {
+			double total = 0.0;
+			for (int column = 0; column < inputA->columns; column++) {
+				total += nn_Matrix_get(inputA, inputARow, column) * nn_Matrix_get(inputB, inputBRow, column);
+			}
+			nn_Matrix_set(this, inputARow, inputBRow, total);
+		}
+	}
+}
+
+// Adds the dot product of input A transposed and input B to this matrix, i.e. each column of input A is
+// multiplied by each column of input B. Used to accumulate weight updates over a batch of examples.
+void nn_Matrix_addDotProductTransposingA(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB) {
+	for (int inputAColumn = 0; inputAColumn < inputA->columns; inputAColumn++) {
+		for (int inputBColumn = 0; inputBColumn < inputB->columns; inputBColumn++) {
+			double total = 0.0;
+			for (int row = 0; row < inputA->rows; row++) {
+				total += nn_Matrix_get(inputA, row, inputAColumn) * nn_Matrix_get(inputB, row, inputBColumn);
+			}
+			this->data[this->columns * inputAColumn + inputBColumn] += total;
+		}
+	}
+}
+
 nn_Matrix *nn_Matrix_allocByMultiplyingAfterApplyingFunctions(nn_Matrix *inputA, nn_Matrix *inputB,
 		double (*functionToApplyA)(double, double), double (*functionToApplyB)(double, double)) {
 	nn_Matrix *this = nn_Matrix_alloc(inputA->rows, inputA->columns);
@@ -69,6 +136,13 @@ nn_Matrix *nn_Matrix_allocByMultiplyingAfterApplyingFunctions(nn_Matrix *inputA,
 	return this;
 }
 
+// Copies `numberOfRows` rows starting at `firstRow` into a new matrix, e.g. to split a batch of examples.
+nn_Matrix *nn_Matrix_allocWithRows(nn_Matrix *this, int firstRow, int numberOfRows) {
+	nn_Matrix *rows = nn_Matrix_alloc(numberOfRows, this->columns);
+	memcpy(rows->data, this->data + firstRow * this->columns, sizeof(double) * numberOfRows * this->columns);
+	return rows;
+}
+
 void nn_Matrix_free(nn_Matrix *this) {
 	free(this->data);
 	free(this);
@@ -89,6 +163,10 @@ void nn_Matrix_fillWithValues(nn_Matrix *this, ...) {
 	va_end(argp);
 }
 
+void nn_Matrix_fillWithZeros(nn_Matrix *this) {
+	memset(this->data, 0, sizeof(double) * this->rows * this->columns);
+}
+
 void nn_Matrix_fillWithValuesArgp(nn_Matrix *this, va_list argp) {
 	int numberOfValues = this->rows * this->columns;
 	for (int i = 0; i < numberOfValues; i++) {
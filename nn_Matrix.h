@@ -17,12 +17,20 @@ nn_Matrix *nn_Matrix_allocWithDotProduct(nn_Matrix *inputA, nn_Matrix *inputB);
 nn_Matrix *nn_Matrix_allocWithDotProductThenFunctionApplied(nn_Matrix *inputA, nn_Matrix *inputB, double (*functionToApply)(double));
 nn_Matrix *nn_Matrix_allocByMultiplyingAfterApplyingFunctions(nn_Matrix *inputA, nn_Matrix *inputB,
 		double (*functionToApplyA)(double, double), double (*functionToApplyB)(double, double));
+nn_Matrix *nn_Matrix_allocWithRows(nn_Matrix *this, int firstRow, int numberOfRows);
 void nn_Matrix_free(nn_Matrix *this);
 double nn_Matrix_get(nn_Matrix *this, int row, int column);
 void nn_Matrix_set(nn_Matrix *this, int row, int column, double value);
 void nn_Matrix_fillWithValues(nn_Matrix *this, ...);
 void nn_Matrix_fillWithValuesArgp(nn_Matrix *this, va_list argp);
 void nn_Matrix_fillWithDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB, double (*functionToApply)(double));
+void nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB,
+		double (*functionToApply)(double), int firstColumn, int endColumn);
+void nn_Matrix_fillColumnsWithBlockedDotProductThenFunctionApplied(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB,
+		double (*functionToApply)(double), int firstColumn, int endColumn, int blockSize);
+void nn_Matrix_fillWithDotProductTransposingB(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB);
+void nn_Matrix_addDotProductTransposingA(nn_Matrix *this, nn_Matrix *inputA, nn_Matrix *inputB);
+void nn_Matrix_fillWithZeros(nn_Matrix *this);
 double nn_Matrix_singleAverageAfterApplyingFunction(nn_Matrix *this, nn_Matrix *other, double (*functionToApply)(double, double));
 void nn_Matrix_print(nn_Matrix *this);
 
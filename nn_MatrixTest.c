@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "nn_Matrix.h"
 
@@ -108,6 +109,63 @@ int main() {
 		nn_Matrix_free(result);
 	}
 
+	// Test nn_Matrix_fillColumnsWithDotProductThenFunctionApplied, scenario: only some columns are filled
+	{
+		nn_Matrix *inputA = nn_Matrix_allocWithValues(1, 2,
+			1.0, 1.0
+		);
+		nn_Matrix *inputB = nn_Matrix_allocWithValues(2, 3,
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix *result = nn_Matrix_allocWithValues(1, 3,
+			9.0, 9.0, 9.0
+		);
+		nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(result, inputA, inputB, addOne, 1, 3);
+		assert(nn_Matrix_get(result, 0, 0) == 9.0);
+		assert(nn_Matrix_get(result, 0, 1) == 2.0);
+		assert(nn_Matrix_get(result, 0, 2) == 1.0);
+		nn_Matrix_free(inputA);
+		nn_Matrix_free(inputB);
+		nn_Matrix_free(result);
+	}
+
+	// Test nn_Matrix_fillColumnsWithBlockedDotProductThenFunctionApplied, scenario: same as unblocked for any block size
+	// (to within rounding, since fused multiply-adds can make the last bits differ)
+	{
+		nn_Matrix *inputA = nn_Matrix_alloc(3, 7);
+		nn_Matrix *inputB = nn_Matrix_alloc(7, 10);
+		for (int i = 0; i < 3 * 7; i++) {
+			inputA->data[i] = (i % 5) * 0.3 - 0.7;
+		}
+		for (int i = 0; i < 7 * 10; i++) {
+			inputB->data[i] = (i % 11) * 0.1 - 0.5;
+		}
+		nn_Matrix *expected = nn_Matrix_alloc(3, 10);
+		nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(expected, inputA, inputB, addOne, 0, 10);
+		nn_Matrix *result = nn_Matrix_alloc(3, 10);
+		for (int blockSize = 1; blockSize <= 12; blockSize++) {
+			for (int i = 0; i < 3 * 10; i++) {
+				result->data[i] = 9.0;
+			}
+			nn_Matrix_fillColumnsWithBlockedDotProductThenFunctionApplied(result, inputA, inputB, addOne, 2, 9, blockSize);
+			for (int row = 0; row < 3; row++) {
+				for (int column = 0; column < 10; column++) {
+					if (column < 2 || column >= 9) {
+						assert(nn_Matrix_get(result, row, column) == 9.0);
+					}
+					else {
+						assert(fabs(nn_Matrix_get(result, row, column) - nn_Matrix_get(expected, row, column)) < 1e-12);
+					}
+				}
+			}
+		}
+		nn_Matrix_free(result);
+		nn_Matrix_free(expected);
+		nn_Matrix_free(inputA);
+		nn_Matrix_free(inputB);
+	}
+
 	// Test nn_Matrix_allocByMultiplyingAfterApplyingFunctions, scenario: basic
 	{
 		nn_Matrix *a = nn_Matrix_allocWithValues(2, 2,
@@ -125,6 +183,76 @@ int main() {
 		assert(nn_Matrix_get(matrix, 1, 1) == 144.0);
 	}
 
+	// Test nn_Matrix_allocWithRows, scenario: basic
+	{
+		nn_Matrix *matrix = nn_Matrix_allocWithValues(3, 2,
+			0.0, 1.0,
+			2.0, 3.0,
+			4.0, 5.0
+		);
+		nn_Matrix *rows = nn_Matrix_allocWithRows(matrix, 1, 2);
+		assert(rows->rows == 2);
+		assert(rows->columns == 2);
+		assert(nn_Matrix_get(rows, 0, 0) == 2.0);
+		assert(nn_Matrix_get(rows, 0, 1) == 3.0);
+		assert(nn_Matrix_get(rows, 1, 0) == 4.0);
+		assert(nn_Matrix_get(rows, 1, 1) == 5.0);
+		nn_Matrix_free(matrix);
+		nn_Matrix_free(rows);
+	}
+
+	// Test nn_Matrix_fillWithDotProductTransposingB, scenario: basic
+	{
+		nn_Matrix *inputA = nn_Matrix_allocWithValues(2, 3,
+			1.0, 0.0, 1.0,
+			0.0, 1.0, 1.0
+		);
+		nn_Matrix *inputB = nn_Matrix_allocWithValues(2, 3,
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix *result = nn_Matrix_alloc(2, 2);
+		nn_Matrix_fillWithDotProductTransposingB(result, inputA, inputB);
+		assert(nn_Matrix_get(result, 0, 0) == 0.0);
+		assert(nn_Matrix_get(result, 0, 1) == -3.0);
+		assert(nn_Matrix_get(result, 1, 0) == 2.0);
+		assert(nn_Matrix_get(result, 1, 1) == -1.0);
+		nn_Matrix_free(inputA);
+		nn_Matrix_free(inputB);
+		nn_Matrix_free(result);
+	}
+
+	// Test nn_Matrix_addDotProductTransposingA, scenario: basic
+	{
+		nn_Matrix *inputA = nn_Matrix_allocWithValues(2, 2,
+			1.0, 2.0,
+			3.0, 4.0
+		);
+		nn_Matrix *inputB = nn_Matrix_allocWithValues(2, 1,
+			1.0,
+			-1.0
+		);
+		nn_Matrix *result = nn_Matrix_allocWithValues(2, 1,
+			10.0,
+			20.0
+		);
+		nn_Matrix_addDotProductTransposingA(result, inputA, inputB);
+		assert(nn_Matrix_get(result, 0, 0) == 8.0);
+		assert(nn_Matrix_get(result, 1, 0) == 18.0);
+		nn_Matrix_free(inputA);
+		nn_Matrix_free(inputB);
+		nn_Matrix_free(result);
+	}
+
+	// Test nn_Matrix_fillWithZeros, scenario: basic
+	{
+		nn_Matrix *matrix = nn_Matrix_allocWithValues(1, 2, 1.0, 2.0);
+		nn_Matrix_fillWithZeros(matrix);
+		assert(nn_Matrix_get(matrix, 0, 0) == 0.0);
+		assert(nn_Matrix_get(matrix, 0, 1) == 0.0);
+		nn_Matrix_free(matrix);
+	}
+
 	// Test nn_Matrix_get, scenario: basic
 	{
 		nn_Matrix *matrix = nn_Matrix_allocWithValues(2, 3,
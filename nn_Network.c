@@ -1,21 +1,38 @@
-#include <stdlib.h>	// malloc, free, rand, RAND_MAX, srand
-#include <string.h>	// strlen, strcpy, strtok
+#include <stdlib.h>	// malloc, calloc, free, rand, RAND_MAX, srand
+#include <string.h>	// strlen, strcpy, strtok, memcpy
 #include <stdarg.h>	// va_list, va_start, va_arg
 #include <time.h>	// time
-#include <math.h>	// exp
+#include <math.h>	// exp, ldexp
 #include <stdio.h>	// printf, fopen
+#include <stdint.h>	// uint16_t, uint32_t, uint64_t
+#ifdef __F16C__
+#include <immintrin.h>	// _mm256_cvtph_ps, _mm256_cvtps_pd
+#endif
 
 #include "nn_Network.h"
+#include "nn_Expression.h"
+
+// Number of exponent and mantissa bits in each of the NN_PRECISION_ formats that fit in 16 bits
+#define NN_PRECISION_EXPONENT_BITS(precision)	((precision) == NN_PRECISION_HALF ? 5 : 8)
+#define NN_PRECISION_MANTISSA_BITS(precision)	((precision) == NN_PRECISION_HALF ? 10 : 7)
 
 // 'private' functions
 double nn_Network__sigmoid(double input);
-double nn_Network__derivativeOfSigmoid(double sigmoid, double unused);
-double nn_Network__cost(double desiredOutput, double networkOutput);
-double nn_Network__derivativeOfCost(double computedOutput, double desiredOutput);
+nn_Matrix *nn_Network__inferenceForTraining(nn_Network *this, nn_Matrix *inputs, nn_SparseMatrix *sparseInputs);
+double nn_Network__trainAfterInference(nn_Network *this, nn_Matrix *trainingDataOutputs, nn_SparseMatrix *sparseInputs,
+		double trainingIncrement);
+double nn_Network__backwardPass(nn_Network *this, nn_Matrix *trainingDataOutputs, nn_Matrix **layerUpdates,
+		nn_SparseMatrix *sparseInputs, double sparseInputsScale);
+nn_Matrix **nn_Network__allocLayerUpdatesFromLayer(nn_Network *this, int firstLayer);
+bool nn_Network__isCheckpointLayer(nn_Network *this, int layer, int checkpointInterval);
+uint16_t nn_Network__narrow(double value, int precision);
+void nn_Network__widen(double *values, uint16_t *narrowValues, int count, int precision);
+double nn_Network__widenOne(uint16_t narrowValue, int precision);
 
 nn_Network *nn_Network_alloc(char *layout) {
 	nn_Network *this = malloc(sizeof(nn_Network));
 	this->layerActivations = NULL;
+	this->layerBlockSizes = NULL;
 
 	this->numberOfLayers = 1;	// starts at 1 because there will be one more layer than there are commas
 	for (int i = 0; layout[i] != '\0'; i++) {
@@ -61,6 +78,9 @@ nn_Network *nn_Network_alloc(char *layout) {
 // - int (rows)
 // - int (columns)
 // - array/sequence of doubles (amount of doubles is: rows x columns)
+// If numberOfLayers is negative (i.e. written by nn_Network_writeToFileWithPrecision with something other than
+// NN_PRECISION_DOUBLE), the number of layers is -numberOfLayers, and each layer has an int (one of the
+// NN_PRECISION_ values) after `columns` for the precision of its weights, which are widened to doubles when read.
 // TODO: Handle corrupt file
 nn_Network *nn_Network_allocFromFile(char *filename) {
 	// make sure there's no '.lock' file
@@ -76,30 +96,50 @@ nn_Network *nn_Network_allocFromFile(char *filename) {
 
 	nn_Network *this = malloc(sizeof(nn_Network));
 	this->layerActivations = NULL;
+	this->layerBlockSizes = NULL;
 
 	// create .lock file
 	lock = fopen(lockFileName, "w");
 	fclose(lock);
 
-	FILE *file = fopen(filename, "r");
+	FILE *file = fopen(filename, "rb");
 	if (file == NULL) {
-		printf("Error opening file '%s' to read weights from.", filename);
+		printf("Error opening file '%s' to read weights from.\n", filename);
+		remove(lockFileName);
+		free(lockFileName);
+		free(this);
 		return NULL;
 	}
 
 	fread(&(this->numberOfLayers), sizeof(int), 1, file);
+	bool hasPrecisions = this->numberOfLayers < 0;
+	if (hasPrecisions) {
+		this->numberOfLayers = -this->numberOfLayers;
+	}
 	this->layerWeights = malloc(sizeof(nn_Matrix *) * this->numberOfLayers);
 
 	int rows, columns;
+	int precision = NN_PRECISION_DOUBLE;
 	// starts at layer 1 because there are no weights at the input layer
 	for (int l = 1; l < this->numberOfLayers; l++) {
 		fread(&rows, sizeof(int), 1, file);
 		fread(&columns, sizeof(int), 1, file);
+		if (hasPrecisions) {
+			fread(&precision, sizeof(int), 1, file);
+		}
 		if (l == 1) {
 			this->numberOfInputs = rows;
 		}
 		this->layerWeights[l] = nn_Matrix_alloc(rows, columns);
-		fread(this->layerWeights[l]->data, sizeof(double), rows * columns, file);
+		if (precision == NN_PRECISION_DOUBLE) {
+			fread(this->layerWeights[l]->data, sizeof(double), rows * columns, file);
+		}
+		else {
+			uint16_t *narrowWeights = malloc(sizeof(uint16_t) * rows * columns);
+			fread(narrowWeights, sizeof(uint16_t), rows * columns, file);
+			nn_Network__widen(this->layerWeights[l]->data, narrowWeights, rows * columns, precision);
+			free(narrowWeights);
+		}
 	}
 
 	fclose(file);
@@ -110,6 +150,26 @@ nn_Network *nn_Network_allocFromFile(char *filename) {
 	return this;
 }
 
+// Makes a new network with the same layout and weights (but not activations) as this one.
+nn_Network *nn_Network_allocCopy(nn_Network *this) {
+	nn_Network *copy = malloc(sizeof(nn_Network));
+	copy->numberOfLayers = this->numberOfLayers;
+	copy->numberOfInputs = this->numberOfInputs;
+	copy->layerActivations = NULL;
+	copy->layerBlockSizes = NULL;
+	if (this->layerBlockSizes != NULL) {
+		copy->layerBlockSizes = malloc(sizeof(int) * this->numberOfLayers);
+		memcpy(copy->layerBlockSizes, this->layerBlockSizes, sizeof(int) * this->numberOfLayers);
+	}
+	copy->layerWeights = malloc(sizeof(nn_Matrix *) * this->numberOfLayers);
+	// starts at 1 because there are no weights at the input layer
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		copy->layerWeights[l] = nn_Matrix_alloc(this->layerWeights[l]->rows, this->layerWeights[l]->columns);
+	}
+	nn_Network_copyWeightsFromNetwork(copy, this);
+	return copy;
+}
+
 void nn_Network_free(nn_Network *this) {
 	// Starts at 1 because we didn't allocate weights for the first layer
 	for (int l = 1; l < this->numberOfLayers; l++) {
@@ -122,6 +182,7 @@ void nn_Network_free(nn_Network *this) {
 		}
 		free(this->layerActivations);
 	}
+	free(this->layerBlockSizes);
 	free(this->layerWeights);
 	free(this);
 }
@@ -159,9 +220,39 @@ nn_Matrix *nn_Network_inferenceWithValuesArgp(nn_Network *this, va_list argp) {
 	return nn_Network_inference(this, inputs);
 }
 
+// Returns a new matrix with the outputs, which the caller needs to free. Unlike nn_Network_inference, the network
+// isn't changed, so any number of threads can use the same network at the same time.
+nn_Matrix *nn_Network_allocInference(nn_Network *this, nn_Matrix *inputs) {
+	nn_Matrix *previousActivations = inputs;
+	nn_Matrix *activations = NULL;
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		activations = nn_Matrix_alloc(inputs->rows, this->layerWeights[l]->columns);
+		nn_Network_fillActivationsAtLayer(this, l, activations, previousActivations);
+		// only the outputs are kept
+		if (previousActivations != inputs) {
+			nn_Matrix_free(previousActivations);
+		}
+		previousActivations = activations;
+	}
+	return activations;
+}
+
 // inferenceForTraining keeps the outputs/activations from each layer.
 nn_Matrix *nn_Network_inferenceForTraining(nn_Network *this, nn_Matrix *inputs) {
-	// allocate memory for activations at each layer (if not already allocated)
+	return nn_Network__inferenceForTraining(this, inputs, NULL);
+}
+
+// Same as nn_Network_inferenceForTraining, but the inputs only list the values that aren't zero (e.g. one-hot
+// encoded inputs), and the first layer only reads the rows of weights for those inputs.
+// The returned outputs belong to the network, and are overwritten by the next call.
+nn_Matrix *nn_Network_inferenceWithSparseInputs(nn_Network *this, nn_SparseMatrix *inputs) {
+	return nn_Network__inferenceForTraining(this, NULL, inputs);
+}
+
+// Only one of `inputs` and `sparseInputs` is used, the other should be NULL.
+nn_Matrix *nn_Network__inferenceForTraining(nn_Network *this, nn_Matrix *inputs, nn_SparseMatrix *sparseInputs) {
+	int numberOfExamples = inputs != NULL ? inputs->rows : sparseInputs->rows;
+	// allocate memory for activations at each layer (if not already allocated for this many examples)
 	if (this->layerActivations == NULL) {
 		this->layerActivations = calloc(this->numberOfLayers, sizeof(nn_Network *));
 	}
@@ -170,15 +261,21 @@ nn_Matrix *nn_Network_inferenceForTraining(nn_Network *this, nn_Matrix *inputs)
 	// and activations which are stored for back propagation.
 	// (starts at 1 becuase there are no weights at the input layer)
 	for (int l = 1; l < this->numberOfLayers; l++) {
+		if (this->layerActivations[l] != NULL && this->layerActivations[l]->rows != numberOfExamples) {
+			nn_Matrix_free(this->layerActivations[l]);
+			this->layerActivations[l] = NULL;
+		}
+		if (this->layerActivations[l] == NULL) {
+			this->layerActivations[l] = nn_Matrix_alloc(numberOfExamples, this->layerWeights[l]->columns);
+		}
 		// Calculate the weighted sums (dot product) of previous layer activations and weights at this level,
 		// then calculate the 'activation' value by applying the sigmoid function to the result.
-		if (this->layerActivations[l] == NULL) {
-			this->layerActivations[l] = nn_Matrix_allocWithDotProductThenFunctionApplied(
-					this->layerActivations[l - 1], this->layerWeights[l], nn_Network__sigmoid);
+		if (l == 1 && sparseInputs != NULL) {
+			nn_SparseMatrix_fillMatrixWithGatheredRowsThenFunctionApplied(sparseInputs, this->layerActivations[l],
+					this->layerWeights[l], nn_Network__sigmoid);
 		}
 		else {
-			nn_Matrix_fillWithDotProductThenFunctionApplied(this->layerActivations[l],
-					this->layerActivations[l - 1], this->layerWeights[l], nn_Network__sigmoid);
+			nn_Network_fillActivationsAtLayer(this, l, this->layerActivations[l], this->layerActivations[l - 1]);
 		}
 	}
 	return this->layerActivations[this->numberOfLayers - 1];
@@ -186,82 +283,294 @@ nn_Matrix *nn_Network_inferenceForTraining(nn_Network *this, nn_Matrix *inputs)
 
 double nn_Network_train(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, double trainingIncrement) {
 	// First do a forward pass (inference)
-	nn_Matrix *inferenceOutputs = nn_Network_inferenceForTraining(this, trainingDataInputs);
+	nn_Network_inferenceForTraining(this, trainingDataInputs);
+	// Then a backward pass
+	return nn_Network__trainAfterInference(this, trainingDataOutputs, NULL, trainingIncrement);
+}
 
-	// Calculate a single, overall average cost
-	double averageCost = nn_Matrix_singleAverageAfterApplyingFunction(inferenceOutputs, trainingDataOutputs, nn_Network__cost);
+// Same as nn_Network_train, but with inputs that only list the values that aren't zero. The updates for
+// the first layer are only added to the rows of weights for those inputs.
+double nn_Network_trainWithSparseInputs(nn_Network *this, nn_SparseMatrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement) {
+	nn_Network_inferenceWithSparseInputs(this, trainingDataInputs);
+	return nn_Network__trainAfterInference(this, trainingDataOutputs, trainingDataInputs, trainingIncrement);
+}
 
-	// Then do a backward pass, iterating backwards through the network calculating updates for each of the
-	// weights based on direction and magnitude of gradient of each weight with respect to the final error/cost.
-	// Updates are calculated during backwards pass, but not applied until after the backward pass is complete.
+// The backward pass of training, `sparseInputs` should be the inputs if they were sparse, otherwise NULL.
+double nn_Network__trainAfterInference(nn_Network *this, nn_Matrix *trainingDataOutputs, nn_SparseMatrix *sparseInputs,
+		double trainingIncrement) {
+	nn_Matrix *inferenceOutputs = this->layerActivations[this->numberOfLayers - 1];
+	int numberOfExamples = inferenceOutputs->rows;
 
-	// Allocate some space to store the updates while the backward pass is in progress.
-	nn_Matrix **layerUpdates = malloc(sizeof(nn_Matrix *) * this->numberOfLayers);
+	// Allocate some space to store the updates while the backward pass is in progress. With sparse inputs the
+	// first layer's updates go straight into its weights, so it doesn't get any (it's as big as the whole layer).
+	nn_Matrix **layerUpdates = nn_Network__allocLayerUpdatesFromLayer(this, sparseInputs != NULL ? 2 : 1);
 
-	nn_Matrix *deltas = NULL;
-	nn_Matrix *previousDeltas = NULL;
-	for (int layer = this->numberOfLayers - 1; layer >= 1; layer--) {	// only goes down to index 1 because layer[0] has no weights
-		// Compute the deltas for this layer
-		if (layer == this->numberOfLayers - 1) {
-			// for the output layer, deltas are the derivative of cost function times derivative of sigmoid output
-			deltas = nn_Matrix_allocByMultiplyingAfterApplyingFunctions(inferenceOutputs, trainingDataOutputs,
-					nn_Network__derivativeOfCost, nn_Network__derivativeOfSigmoid);
+	double totalCost = nn_Network__backwardPass(this, trainingDataOutputs, layerUpdates, sparseInputs,
+			trainingIncrement / numberOfExamples);
+
+	// apply updates (the first layer's updates have already been applied if the inputs were sparse)
+	for (int layer = sparseInputs != NULL ? 2 : 1; layer < this->numberOfLayers; layer++) {
+		nn_Network_applyUpdatesAtLayer(this, layer, layerUpdates[layer], trainingIncrement / numberOfExamples);
+	}
+	nn_Network_freeLayerUpdates(this, layerUpdates);
+
+	// single, overall average cost
+	return totalCost / (inferenceOutputs->rows * inferenceOutputs->columns);
+}
+
+// Does a forward and backward pass like nn_Network_train, but instead of changing the weights, fills `layerUpdates`
+// (from nn_Network_allocLayerUpdates) with the updates summed over all examples. Returns the total cost.
+// This lets updates from different batches be added together before they're applied with nn_Network_applyUpdates.
+double nn_Network_fillUpdates(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, nn_Matrix **layerUpdates) {
+	nn_Network_inferenceForTraining(this, trainingDataInputs);
+	return nn_Network__backwardPass(this, trainingDataOutputs, layerUpdates, NULL, 0.0);
+}
+
+// Same as nn_Network_train, but to use less memory with large batches, only the activations at every
+// `checkpointInterval` layers (and the outputs) are kept from the forward pass. During the backward pass the
+// activations in between are calculated again from the nearest kept layer below, one segment at a time.
+// Costs about one more forward pass. See nn_Network_activationBytesForTraining for the memory it needs.
+// A `checkpointInterval` below 1 is taken as 1.
+double nn_Network_trainWithRecomputation(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement, int checkpointInterval) {
+	if (checkpointInterval < 1) {
+		checkpointInterval = 1;
+	}
+	int numberOfExamples = trainingDataInputs->rows;
+	int outputLayer = this->numberOfLayers - 1;
+	// NULL for layers that aren't currently calculated
+	nn_Matrix **layerActivations = calloc(this->numberOfLayers, sizeof(nn_Matrix *));
+	layerActivations[0] = trainingDataInputs;
+
+	// Forward pass, only keeping the checkpoint layers
+	for (int l = 1; l <= outputLayer; l++) {
+		layerActivations[l] = nn_Matrix_alloc(numberOfExamples, this->layerWeights[l]->columns);
+		nn_Network_fillActivationsAtLayer(this, l, layerActivations[l], layerActivations[l - 1]);
+		if (!nn_Network__isCheckpointLayer(this, l - 1, checkpointInterval)) {
+			nn_Matrix_free(layerActivations[l - 1]);
+			layerActivations[l - 1] = NULL;
+		}
+	}
+
+	nn_Matrix *deltas = nn_Matrix_alloc(numberOfExamples, layerActivations[outputLayer]->columns);
+	double totalCost = nn_Network_fillOutputDeltas(this, deltas, layerActivations[outputLayer], trainingDataOutputs);
+
+	// Same as nn_Network__backwardPass, except for recalculating the activations below each layer when needed
+	nn_Matrix **layerUpdates = nn_Network_allocLayerUpdates(this);
+	for (int layer = outputLayer; layer >= 1; layer--) {
+		if (layerActivations[layer - 1] == NULL) {
+			// Entering a new segment, so recalculate every layer in it from the checkpoint at the bottom
+			int checkpoint = (layer - 1) / checkpointInterval * checkpointInterval;
+			for (int l = checkpoint + 1; l < layer; l++) {
+				layerActivations[l] = nn_Matrix_alloc(numberOfExamples, this->layerWeights[l]->columns);
+				nn_Network_fillActivationsAtLayer(this, l, layerActivations[l], layerActivations[l - 1]);
+			}
+		}
+
+		nn_Matrix_fillWithZeros(layerUpdates[layer]);
+		nn_Matrix_addDotProductTransposingA(layerUpdates[layer], layerActivations[layer - 1], deltas);
+
+		if (layer > 1) {
+			nn_Matrix *errors = nn_Matrix_alloc(numberOfExamples, layerActivations[layer - 1]->columns);
+			nn_Network_fillErrorsBelowLayer(this, layer, errors, deltas);
+			nn_Matrix_free(deltas);
+			deltas = errors;
+			nn_Network_fillHiddenDeltas(this, deltas, errors, layerActivations[layer - 1]);
+		}
+		// this layer's activations aren't needed any more
+		nn_Matrix_free(layerActivations[layer]);
+		layerActivations[layer] = NULL;
+	}
+	nn_Matrix_free(deltas);
+	free(layerActivations);
+
+	nn_Network_applyUpdates(this, layerUpdates, trainingIncrement / numberOfExamples);
+	nn_Network_freeLayerUpdates(this, layerUpdates);
+
+	// single, overall average cost
+	return totalCost / (trainingDataOutputs->rows * trainingDataOutputs->columns);
+}
+
+// The most memory used at once for activations when training with `numberOfExamples` examples (an upper bound,
+// since it adds up every checkpoint layer), not counting the inputs. A `checkpointInterval` of 1 (or below) keeps every layer, which is the same as nn_Network_train.
+// Weights, updates and deltas take the same memory whatever the interval, so they're not included.
+size_t nn_Network_activationBytesForTraining(nn_Network *this, int numberOfExamples, int checkpointInterval) {
+	if (checkpointInterval < 1) {
+		checkpointInterval = 1;
+	}
+	size_t checkpointBytes = 0;
+	size_t mostRecalculatedBytes = 0;
+	size_t recalculatedBytes = 0;
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		size_t layerBytes = sizeof(double) * numberOfExamples * nn_Network_numberOfNodesAtLayerIndex(this, l);
+		if (nn_Network__isCheckpointLayer(this, l, checkpointInterval)) {
+			checkpointBytes += layerBytes;
+			recalculatedBytes = 0;
 		}
 		else {
-			// deltas for other layers are calculated by taking each node in the current layer and summing the deltas from the
-			// previous layer times the weight from this layer to previous layer times the derivative of the activations.
-			nn_Matrix *thisLayerActivations = this->layerActivations[layer];
-			deltas = nn_Matrix_alloc(thisLayerActivations->rows, thisLayerActivations->columns);
-			for (int column = 0; column < thisLayerActivations->columns; column++) {
-				for (int example = 0; example < thisLayerActivations->rows; example++) {
-					double sum = 0.0;
-					double activation = nn_Matrix_get(this->layerActivations[layer], example, column);
-					double derivativeOfActivation = activation * (1 - activation);
-					for (int previousDeltaColumn = 0; previousDeltaColumn < previousDeltas->columns; previousDeltaColumn++) {
-						sum += nn_Matrix_get(previousDeltas, example, previousDeltaColumn) *
-								nn_Matrix_get(this->layerWeights[layer + 1], column, previousDeltaColumn) *
-								derivativeOfActivation;
-
-					}
-					nn_Matrix_set(deltas, example, column, sum);
-				}
+			// during the backward pass, a whole segment is calculated again at once
+			recalculatedBytes += layerBytes;
+			if (recalculatedBytes > mostRecalculatedBytes) {
+				mostRecalculatedBytes = recalculatedBytes;
 			}
 		}
-		// Calculate the derivative of cost with respect to each weight in this layer.
-		// This is calculated as the average across all examples, of the delta for a node in this layer for a weight,
-		// times the activation for the corresponding node from the previous layer corresponding to the same weight.
-		layerUpdates[layer] = nn_Matrix_alloc(this->layerWeights[layer]->rows, this->layerWeights[layer]->columns);
-		for (int weightRow = 0; weightRow < this->layerWeights[layer]->rows; weightRow++) {
-			for (int weightColumn = 0; weightColumn < this->layerWeights[layer]->columns; weightColumn++) {
-				double weightTotal = 0;
-				for (int example = 0; example < deltas->rows; example++) {
-					weightTotal += nn_Matrix_get(deltas, example, weightColumn) *
-							nn_Matrix_get(this->layerActivations[layer - 1], example, weightRow);
-				}
-				nn_Matrix_set(layerUpdates[layer], weightRow, weightColumn, weightTotal / deltas->rows);
+		// during the forward pass, a layer that isn't kept is only freed after the next one has been calculated
+		if (l > 1 && !nn_Network__isCheckpointLayer(this, l - 1, checkpointInterval)) {
+			size_t previousLayerBytes = sizeof(double) * numberOfExamples * nn_Network_numberOfNodesAtLayerIndex(this, l - 1);
+			size_t forwardBytes = previousLayerBytes + (nn_Network__isCheckpointLayer(this, l, checkpointInterval) ? 0 : layerBytes);
+			if (forwardBytes > mostRecalculatedBytes) {
+				mostRecalculatedBytes = forwardBytes;
 			}
 		}
+	}
+	return checkpointBytes + mostRecalculatedBytes;
+}
 
-		// store deltas to use next time around this loop
-		if (previousDeltas) {
-			nn_Matrix_free(previousDeltas);
+// Layers whose activations are kept by nn_Network_trainWithRecomputation, the inputs and outputs are always kept.
+bool nn_Network__isCheckpointLayer(nn_Network *this, int layer, int checkpointInterval) {
+	return layer % checkpointInterval == 0 || layer == this->numberOfLayers - 1;
+}
+
+// Iterates backwards through the network calculating updates for each of the weights based on direction
+// and magnitude of gradient of each weight with respect to the final error/cost, and returns the total cost.
+// Updates are added to `layerUpdates`, which is zeroed first. If `sparseInputs` isn't NULL, the first layer's
+// updates are added straight to its weights times `sparseInputsScale` instead.
+double nn_Network__backwardPass(nn_Network *this, nn_Matrix *trainingDataOutputs, nn_Matrix **layerUpdates,
+		nn_SparseMatrix *sparseInputs, double sparseInputsScale) {
+	nn_Matrix *inferenceOutputs = this->layerActivations[this->numberOfLayers - 1];
+
+	// For the output layer, deltas are the derivative of cost function times derivative of sigmoid output.
+	// The same pass also gives us the total cost.
+	nn_Matrix *deltas = nn_Matrix_alloc(inferenceOutputs->rows, inferenceOutputs->columns);
+	double totalCost = nn_Network_fillOutputDeltas(this, deltas, inferenceOutputs, trainingDataOutputs);
+
+	for (int layer = this->numberOfLayers - 1; layer >= 1; layer--) {	// only goes down to index 1 because layer[0] has no weights
+		if (layer == 1 && sparseInputs != NULL) {
+			// Nothing is below the first layer, so its weights aren't needed any more and the updates for the
+			// rows of weights used by the sparse inputs can be added straight away.
+			nn_SparseMatrix_scatterAddToMatrix(sparseInputs, this->layerWeights[layer], deltas, sparseInputsScale);
+			break;
 		}
-		previousDeltas = deltas;
+
+		// Calculate the derivative of cost with respect to each weight in this layer.
+		// This is the sum across all examples, of the delta for a node in this layer for a weight, times the
+		// activation for the corresponding node from the previous layer corresponding to the same weight.
+		// (it's turned into an average when the updates are applied)
+		nn_Matrix_fillWithZeros(layerUpdates[layer]);
+		nn_Matrix_addDotProductTransposingA(layerUpdates[layer], this->layerActivations[layer - 1], deltas);
+
+		// Compute the deltas for the layer below, these are the deltas from this layer pushed back through
+		// this layer's weights, times the derivative of the activations.
+		if (layer > 1) {
+			nn_Matrix *previousLayerActivations = this->layerActivations[layer - 1];
+			nn_Matrix *errors = nn_Matrix_alloc(previousLayerActivations->rows, previousLayerActivations->columns);
+			nn_Network_fillErrorsBelowLayer(this, layer, errors, deltas);
+			nn_Matrix_free(deltas);
+			deltas = errors;
+			nn_Network_fillHiddenDeltas(this, deltas, errors, previousLayerActivations);
+		}
+	}
+	nn_Matrix_free(deltas);
+
+	return totalCost;
+}
+
+// Allocates a matrix the same size as the weights at each layer, index 0 is unused like in layerWeights.
+nn_Matrix **nn_Network_allocLayerUpdates(nn_Network *this) {
+	return nn_Network__allocLayerUpdatesFromLayer(this, 1);
+}
+
+// Layers below `firstLayer` are NULL.
+nn_Matrix **nn_Network__allocLayerUpdatesFromLayer(nn_Network *this, int firstLayer) {
+	nn_Matrix **layerUpdates = calloc(this->numberOfLayers, sizeof(nn_Matrix *));
+	for (int layer = firstLayer; layer < this->numberOfLayers; layer++) {
+		layerUpdates[layer] = nn_Matrix_alloc(this->layerWeights[layer]->rows, this->layerWeights[layer]->columns);
 	}
-	nn_Matrix_free(previousDeltas);
+	return layerUpdates;
+}
 
-	// apply updates
+void nn_Network_freeLayerUpdates(nn_Network *this, nn_Matrix **layerUpdates) {
 	for (int layer = 1; layer < this->numberOfLayers; layer++) {
-		nn_Matrix *layerWeights = this->layerWeights[layer];
-		int numberOfWeightsInLayer = layerWeights->rows * layerWeights->columns;
-		for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
-			layerWeights->data[weight] += layerUpdates[layer]->data[weight] * trainingIncrement;
+		if (layerUpdates[layer] != NULL) {
+			nn_Matrix_free(layerUpdates[layer]);
 		}
-		nn_Matrix_free(layerUpdates[layer]);
 	}
 	free(layerUpdates);
+}
+
+void nn_Network_applyUpdates(nn_Network *this, nn_Matrix **layerUpdates, double scale) {
+	for (int layer = 1; layer < this->numberOfLayers; layer++) {
+		nn_Network_applyUpdatesAtLayer(this, layer, layerUpdates[layer], scale);
+	}
+}
 
-	return averageCost;
+// Calculates the activations for one layer from the activations of the layer before it.
+void nn_Network_fillActivationsAtLayer(nn_Network *this, int layer, nn_Matrix *activations, nn_Matrix *previousActivations) {
+	nn_Network_fillActivationsAtLayerForNodes(this, layer, activations, previousActivations, 0, this->layerWeights[layer]->columns);
+}
+
+// Only calculates the activations for nodes from `firstNode` up to (but not including) `endNode`.
+void nn_Network_fillActivationsAtLayerForNodes(nn_Network *this, int layer, nn_Matrix *activations, nn_Matrix *previousActivations,
+		int firstNode, int endNode) {
+	if (this->layerBlockSizes != NULL && this->layerBlockSizes[layer] > 0) {
+		nn_Matrix_fillColumnsWithBlockedDotProductThenFunctionApplied(activations, previousActivations, this->layerWeights[layer],
+				nn_Network__sigmoid, firstNode, endNode, this->layerBlockSizes[layer]);
+	}
+	else {
+		nn_Matrix_fillColumnsWithDotProductThenFunctionApplied(activations, previousActivations, this->layerWeights[layer],
+				nn_Network__sigmoid, firstNode, endNode);
+	}
+}
+
+// Fills the deltas for the output layer and returns the total (not average) cost of `outputs`.
+// The cost is the squared error, and the deltas are the derivative of the cost times the derivative of the sigmoid,
+// both worked out in the same pass.
+double nn_Network_fillOutputDeltas(nn_Network *this, nn_Matrix *deltas, nn_Matrix *outputs, nn_Matrix *desiredOutputs) {
+	(void)this;	// only takes the network like the other steps
+	nn_Expression *expression = nn_Expression_alloc();
+	int computed = nn_Expression_matrix(expression, outputs);
+	int error = nn_Expression_subtract(expression, nn_Expression_matrix(expression, desiredOutputs), computed);
+	int derivativeOfCost = nn_Expression_multiply(expression, nn_Expression_constant(expression, 2.0), error);
+	nn_Expression_storeInMatrix(expression,
+			nn_Expression_multiply(expression, derivativeOfCost, nn_Expression_derivativeOfSigmoid(expression, computed)), deltas);
+	double totalCost;
+	nn_Expression_storeSum(expression, nn_Expression_square(expression, error), &totalCost);
+	nn_Expression_evaluate(expression);
+	nn_Expression_free(expression);
+	return totalCost;
+}
+
+// Pushes the deltas at `layer` backwards through that layer's weights, giving an error for each node in the layer below.
+void nn_Network_fillErrorsBelowLayer(nn_Network *this, int layer, nn_Matrix *errors, nn_Matrix *deltas) {
+	nn_Matrix_fillWithDotProductTransposingB(errors, deltas, this->layerWeights[layer]);
+}
+
+// Deltas for hidden layers are the errors pushed back from the layer above, times the derivative of the activations.
+// `deltas` and `errors` can be the same matrix.
+void nn_Network_fillHiddenDeltas(nn_Network *this, nn_Matrix *deltas, nn_Matrix *errors, nn_Matrix *activations) {
+	(void)this;	// only takes the network like the other steps
+	nn_Expression *expression = nn_Expression_alloc();
+	int derivativeOfActivations = nn_Expression_derivativeOfSigmoid(expression, nn_Expression_matrix(expression, activations));
+	nn_Expression_storeInMatrix(expression,
+			nn_Expression_multiply(expression, nn_Expression_matrix(expression, errors), derivativeOfActivations), deltas);
+	nn_Expression_evaluate(expression);
+	nn_Expression_free(expression);
+}
+
+void nn_Network_applyUpdatesAtLayer(nn_Network *this, int layer, nn_Matrix *updates, double scale) {
+	nn_Expression *expression = nn_Expression_alloc();
+	int weights = nn_Expression_matrix(expression, this->layerWeights[layer]);
+	int scaledUpdates = nn_Expression_multiply(expression, nn_Expression_matrix(expression, updates),
+			nn_Expression_constant(expression, scale));
+	nn_Expression_storeInMatrix(expression, nn_Expression_add(expression, weights, scaledUpdates), this->layerWeights[layer]);
+	nn_Expression_evaluate(expression);
+	nn_Expression_free(expression);
+}
+
+// The activation function used at every layer, for code that calculates layers without nn_Network_fillActivationsAtLayer.
+double nn_Network_activation(double weightedSum) {
+	return nn_Network__sigmoid(weightedSum);
 }
 
 int nn_Network_numberOfNodesAtLayerIndex(nn_Network *this, int layerIndex) {
@@ -289,13 +598,59 @@ void nn_Network_randomiseWeightsBetweenMinAndMax(nn_Network *this, double min, d
 	}
 }
 
-// File format is:
-// - int (numberOfLayers)
-// for each layer, except input layer (i.e. numberOfLayers - 1)
-// - int (rows)
-// - int (columns)
-// - array/sequence of doubles (amount of doubles is: rows x columns)
+// Unlike nn_Network_randomiseWeightsBetweenMinAndMax, the weights only depend on `seed`, and it doesn't use the
+// shared rand() state, so networks can be randomised from different threads (e.g. for a hyperparameter sweep).
+void nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(nn_Network *this, double min, double max, unsigned int seed) {
+	unsigned long long state = nn_Network_randomState(seed);
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		int numberOfWeightsInLayer = this->layerWeights[l]->rows * this->layerWeights[l]->columns;
+		for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
+			this->layerWeights[l]->data[weight] = nn_Network_random(&state) * (max - min) + min;
+		}
+	}
+}
+
+// Starting state for nn_Network_random, which only depends on `seed`.
+unsigned long long nn_Network_randomState(unsigned int seed) {
+	// spread the seeds out, and make sure the state isn't 0 (which would stay 0)
+	return seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+// xorshift64*, returns a number from 0 up to (but not including) 1 and moves `state` on.
+double nn_Network_random(unsigned long long *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	unsigned long long value = *state * 0x2545F4914F6CDD1DULL;
+	// top 53 bits, to fill a double's mantissa
+	return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Both networks must have the same layout.
+void nn_Network_copyWeightsFromNetwork(nn_Network *this, nn_Network *other) {
+	// starts at 1 because there are no weights at the input layer
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		memcpy(this->layerWeights[l]->data, other->layerWeights[l]->data,
+				sizeof(double) * this->layerWeights[l]->rows * this->layerWeights[l]->columns);
+	}
+}
+
+// File format is described above nn_Network_allocFromFile
 int nn_Network_writeToFile(nn_Network *this, char *filename) {
+	return nn_Network_writeToFileWithPrecision(this, filename, NN_PRECISION_DOUBLE);
+}
+
+// Writes every layer's weights with `precision`, one of the NN_PRECISION_ values. NN_PRECISION_HALF and
+// NN_PRECISION_BFLOAT16 make files a quarter of the size, rounding each weight to the nearest value they can hold.
+// Half precision keeps more digits, but weights over 65504 become infinity and weights under about 6e-8 become 0.
+// bfloat16 keeps fewer digits, but has the same range as float.
+// Returns 0 on success, or NN_ERROR_WRITE_UNKNOWN_PRECISION, NN_ERROR_WRITE_LOCK_FILE or NN_ERROR_WRITE_FOPEN_FAIL.
+int nn_Network_writeToFileWithPrecision(nn_Network *this, char *filename, int precision) {
+	if (precision != NN_PRECISION_DOUBLE && precision != NN_PRECISION_HALF && precision != NN_PRECISION_BFLOAT16) {
+		printf("Not writing to '%s' because %d isn't a precision.\n", filename, precision);
+		return NN_ERROR_WRITE_UNKNOWN_PRECISION;
+	}
+
 	// make sure there's no '.lock' file
 	char *lockFileName = malloc(sizeof(char) * (strlen(filename) + strlen(".lock") + 1));
 	sprintf(lockFileName, "%s.lock", filename);
@@ -311,22 +666,36 @@ int nn_Network_writeToFile(nn_Network *this, char *filename) {
 	lock = fopen(lockFileName, "w");
 	fclose(lock);
 
-	FILE *file = fopen(filename, "w");
+	FILE *file = fopen(filename, "wb");
 	if (file == NULL) {
 		printf("Error opening file '%s' to write weights to.\n", filename);
 		return NN_ERROR_WRITE_FOPEN_FAIL;
 	}
 
-	fwrite(&(this->numberOfLayers), sizeof(int), 1, file);
+	// doubles are written in the original format, so older versions can still read them
+	int numberOfLayers = precision == NN_PRECISION_DOUBLE ? this->numberOfLayers : -this->numberOfLayers;
+	fwrite(&numberOfLayers, sizeof(int), 1, file);
 	// below starts at 1 because input layer doesn't have weights
 	for (int l = 1; l < this->numberOfLayers; l++) {
 		nn_Matrix *layerWeights = this->layerWeights[l];
+		int numberOfWeightsInLayer = layerWeights->rows * layerWeights->columns;
 		fwrite(&(layerWeights->rows), sizeof(int), 1, file);
 		fwrite(&(layerWeights->columns), sizeof(int), 1, file);
-		fwrite(layerWeights->data,
-				sizeof(double),
-				layerWeights->rows * layerWeights->columns,
-				file);
+		if (precision == NN_PRECISION_DOUBLE) {
+			fwrite(layerWeights->data,
+					sizeof(double),
+					numberOfWeightsInLayer,
+					file);
+		}
+		else {
+			fwrite(&precision, sizeof(int), 1, file);
+			uint16_t *narrowWeights = malloc(sizeof(uint16_t) * numberOfWeightsInLayer);
+			for (int weight = 0; weight < numberOfWeightsInLayer; weight++) {
+				narrowWeights[weight] = nn_Network__narrow(layerWeights->data[weight], precision);
+			}
+			fwrite(narrowWeights, sizeof(uint16_t), numberOfWeightsInLayer, file);
+			free(narrowWeights);
+		}
 	}
 	fclose(file);
 
@@ -340,14 +709,94 @@ double nn_Network__sigmoid(double input) {
 	return 1 / (1 + exp(0 - input));
 }
 
-double nn_Network__derivativeOfSigmoid(double sigmoid, double unused) {
-	return sigmoid * (1 - sigmoid);
+// Rounds to the nearest 16 bit value (ties to even), straight from the bits of the double so there's only
+// one rounding step. Too big becomes infinity, and too small becomes 0 (or a subnormal).
+uint16_t nn_Network__narrow(double value, int precision) {
+	int exponentBits = NN_PRECISION_EXPONENT_BITS(precision);
+	int mantissaBits = NN_PRECISION_MANTISSA_BITS(precision);
+	uint16_t infinity = (uint16_t)(((1 << exponentBits) - 1) << mantissaBits);
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(double));
+	uint16_t sign = (uint16_t)((bits >> 48) & 0x8000);
+	int exponent = (int)((bits >> 52) & 0x7ff);
+	uint64_t mantissa = bits & 0xfffffffffffffULL;
+	if (exponent == 0x7ff) {
+		// infinity, or NaN (which keeps a mantissa bit set)
+		return sign | infinity | (mantissa != 0 ? 1 << (mantissaBits - 1) : 0);
+	}
+	int narrowExponent = exponent - 1023 + (1 << (exponentBits - 1)) - 1;
+	if (narrowExponent >= (1 << exponentBits) - 1) {
+		return sign | infinity;
+	}
+	int shift;
+	if (narrowExponent > 0) {
+		shift = 52 - mantissaBits;
+	}
+	else {
+		// subnormal, the implicit leading 1 becomes part of the mantissa
+		shift = 52 - mantissaBits + 1 - narrowExponent;
+		if (shift > 53) {
+			// less than half the smallest subnormal
+			return sign;
+		}
+		mantissa |= 1ULL << 52;
+		narrowExponent = 0;
+	}
+	uint16_t narrow = (uint16_t)((narrowExponent << mantissaBits) | (mantissa >> shift));
+	uint64_t remainder = mantissa & ((1ULL << shift) - 1);
+	uint64_t halfway = 1ULL << (shift - 1);
+	if (remainder > halfway || (remainder == halfway && (narrow & 1))) {
+		// a carry out of the mantissa goes into the exponent, which is also right for rounding up to infinity
+		narrow++;
+	}
+	return sign | narrow;
 }
 
-double nn_Network__cost(double desiredOutput, double networkOutput) {
-	return pow(desiredOutput - networkOutput, 2);
+void nn_Network__widen(double *values, uint16_t *narrowValues, int count, int precision) {
+	int i = 0;
+	if (precision == NN_PRECISION_BFLOAT16) {
+		// bfloat16 is the top half of a float
+		for (; i < count; i++) {
+			uint32_t bits = (uint32_t)narrowValues[i] << 16;
+			float value;
+			memcpy(&value, &bits, sizeof(float));
+			values[i] = value;
+		}
+		return;
+	}
+#ifdef __F16C__
+	// 8 at a time with the F16C instructions
+	for (; i + 8 <= count; i += 8) {
+		__m256 floats = _mm256_cvtph_ps(_mm_loadu_si128((__m128i *)(narrowValues + i)));
+		_mm256_storeu_pd(values + i, _mm256_cvtps_pd(_mm256_castps256_ps128(floats)));
+		_mm256_storeu_pd(values + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(floats, 1)));
+	}
+#endif
+	for (; i < count; i++) {
+		values[i] = nn_Network__widenOne(narrowValues[i], precision);
+	}
 }
 
-double nn_Network__derivativeOfCost(double computedOutput, double desiredOutput) {
-	return 2 * (desiredOutput - computedOutput);
+double nn_Network__widenOne(uint16_t narrowValue, int precision) {
+	int exponentBits = NN_PRECISION_EXPONENT_BITS(precision);
+	int mantissaBits = NN_PRECISION_MANTISSA_BITS(precision);
+	int bias = (1 << (exponentBits - 1)) - 1;
+	uint64_t sign = (uint64_t)(narrowValue & 0x8000) << 48;
+	int exponent = (narrowValue >> mantissaBits) & ((1 << exponentBits) - 1);
+	uint64_t mantissa = narrowValue & ((1 << mantissaBits) - 1);
+	uint64_t bits;
+	if (exponent == (1 << exponentBits) - 1) {
+		bits = sign | (0x7ffULL << 52) | (mantissa << (52 - mantissaBits));
+	}
+	else if (exponent == 0) {
+		// zero or subnormal
+		double value = ldexp((double)mantissa, 1 - bias - mantissaBits);
+		return sign != 0 ? -value : value;
+	}
+	else {
+		bits = sign | ((uint64_t)(exponent - bias + 1023) << 52) | (mantissa << (52 - mantissaBits));
+	}
+	double value;
+	memcpy(&value, &bits, sizeof(double));
+	return value;
 }
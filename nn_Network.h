@@ -4,33 +4,69 @@
 
 #include <stdarg.h>	// va_list
 #include <stdbool.h>	// bool, true, false
+#include <stddef.h>	// size_t
 
 #include "nn_Matrix.h"
+#include "nn_SparseMatrix.h"
 
 typedef struct {
 	int numberOfLayers;
 	int numberOfInputs;
 	nn_Matrix **layerWeights;
 	nn_Matrix **layerActivations;
+	int *layerBlockSizes;	// block size of the dot product kernel at each layer (0 is unblocked), NULL if not set by nn_Plan
 } nn_Network;
 
 #define NN_ERROR_WRITE_FOPEN_FAIL	1
 #define NN_ERROR_WRITE_LOCK_FILE	2
+#define NN_ERROR_WRITE_UNKNOWN_PRECISION	5
+
+// Precision of the weights in a file, see nn_Network_writeToFileWithPrecision
+#define NN_PRECISION_DOUBLE	0
+#define NN_PRECISION_HALF	1	// IEEE 754 binary16
+#define NN_PRECISION_BFLOAT16	2	// top 16 bits of a float
 
 nn_Network *nn_Network_alloc(char *layout);
 nn_Network *nn_Network_allocFromFile(char *filename);
+nn_Network *nn_Network_allocCopy(nn_Network *this);
 void nn_Network_free(nn_Network *this);
 
 nn_Matrix *nn_Network_inference(nn_Network *this, nn_Matrix *inputs);
 nn_Matrix *nn_Network_inferenceWithValues(nn_Network *this, ...);
 nn_Matrix *nn_Network_inferenceWithValuesArgp(nn_Network *this, va_list argp);
 nn_Matrix *nn_Network_inferenceForTraining(nn_Network *this, nn_Matrix *inputs);
+nn_Matrix *nn_Network_allocInference(nn_Network *this, nn_Matrix *inputs);
 double nn_Network_train(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, double trainingIncrement);
+nn_Matrix *nn_Network_inferenceWithSparseInputs(nn_Network *this, nn_SparseMatrix *inputs);
+double nn_Network_trainWithSparseInputs(nn_Network *this, nn_SparseMatrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement);
+double nn_Network_trainWithRecomputation(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		double trainingIncrement, int checkpointInterval);
+size_t nn_Network_activationBytesForTraining(nn_Network *this, int numberOfExamples, int checkpointInterval);
+double nn_Network_fillUpdates(nn_Network *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, nn_Matrix **layerUpdates);
+nn_Matrix **nn_Network_allocLayerUpdates(nn_Network *this);
+void nn_Network_freeLayerUpdates(nn_Network *this, nn_Matrix **layerUpdates);
+void nn_Network_applyUpdates(nn_Network *this, nn_Matrix **layerUpdates, double scale);
+
+// Individual steps of a training pass, see nn_Network__backwardPass in nn_Network.c for how they fit together.
+void nn_Network_fillActivationsAtLayer(nn_Network *this, int layer, nn_Matrix *activations, nn_Matrix *previousActivations);
+void nn_Network_fillActivationsAtLayerForNodes(nn_Network *this, int layer, nn_Matrix *activations, nn_Matrix *previousActivations,
+		int firstNode, int endNode);
+double nn_Network_fillOutputDeltas(nn_Network *this, nn_Matrix *deltas, nn_Matrix *outputs, nn_Matrix *desiredOutputs);
+void nn_Network_fillErrorsBelowLayer(nn_Network *this, int layer, nn_Matrix *errors, nn_Matrix *deltas);
+void nn_Network_fillHiddenDeltas(nn_Network *this, nn_Matrix *deltas, nn_Matrix *errors, nn_Matrix *activations);
+void nn_Network_applyUpdatesAtLayer(nn_Network *this, int layer, nn_Matrix *updates, double scale);
+double nn_Network_activation(double weightedSum);
 
 int nn_Network_numberOfNodesAtLayerIndex(nn_Network *this, int layerIndex);
 void nn_Network_randomiseWeightsBetweenMinAndMax(nn_Network *this, double min, double max);
+void nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(nn_Network *this, double min, double max, unsigned int seed);
+unsigned long long nn_Network_randomState(unsigned int seed);
+double nn_Network_random(unsigned long long *state);
+void nn_Network_copyWeightsFromNetwork(nn_Network *this, nn_Network *other);
 
 int nn_Network_writeToFile(nn_Network *this, char *filename);
+int nn_Network_writeToFileWithPrecision(nn_Network *this, char *filename, int precision);
 
 
 #endif
@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #include "nn_Network.h"
 
@@ -35,6 +37,91 @@ int main() {
 		nn_Network_free(network);
 	}
 
+	// Test nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed, scenario: same seed gives the same weights
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -3.0, 3.0, 42);
+		nn_Network *same = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(same, -3.0, 3.0, 42);
+		nn_Network *different = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(different, -3.0, 3.0, 43);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				assert(network->layerWeights[l]->data[w] >= -3.0);
+				assert(network->layerWeights[l]->data[w] < 3.0);
+				assert(network->layerWeights[l]->data[w] == same->layerWeights[l]->data[w]);
+				assert(network->layerWeights[l]->data[w] != different->layerWeights[l]->data[w]);
+			}
+		}
+		nn_Network_free(different);
+		nn_Network_free(same);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_allocCopy, scenario: basic
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -3.0, 3.0);
+		nn_Network *copy = nn_Network_allocCopy(network);
+		assert(copy->numberOfLayers == 3);
+		assert(copy->numberOfInputs == 2);
+		assert(copy->layerActivations == NULL);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			assert(copy->layerWeights[l] != network->layerWeights[l]);
+			assert(copy->layerWeights[l]->rows == network->layerWeights[l]->rows);
+			assert(copy->layerWeights[l]->columns == network->layerWeights[l]->columns);
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				assert(copy->layerWeights[l]->data[w] == network->layerWeights[l]->data[w]);
+			}
+		}
+		nn_Network_free(copy);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_copyWeightsFromNetwork, scenario: basic
+	{
+		nn_Network *network = nn_Network_alloc("2, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1], 1.0, 2.0);
+		nn_Network *other = nn_Network_alloc("2, 1");
+		nn_Matrix_fillWithValues(other->layerWeights[1], 3.0, 4.0);
+		nn_Network_copyWeightsFromNetwork(network, other);
+		assert(nn_Matrix_get(network->layerWeights[1], 0, 0) == 3.0);
+		assert(nn_Matrix_get(network->layerWeights[1], 1, 0) == 4.0);
+		nn_Network_free(other);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_allocInference, scenario: basic (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Matrix *outputs = nn_Network_allocInference(network, inputs);
+		assert(network->layerActivations == NULL);
+		assert(outputs->rows == 4);
+		assert(outputs->columns == 1);
+		assert(nn_Matrix_get(outputs, 0, 0) > 0.499 && nn_Matrix_get(outputs, 0, 0) < 0.501);
+		assert(nn_Matrix_get(outputs, 1, 0) > 0.462 && nn_Matrix_get(outputs, 1, 0) < 0.463);
+		assert(nn_Matrix_get(outputs, 2, 0) > 0.681 && nn_Matrix_get(outputs, 2, 0) < 0.682);
+		assert(nn_Matrix_get(outputs, 3, 0) > 0.611 && nn_Matrix_get(outputs, 3, 0) < 0.612);
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(inputs);
+		nn_Network_free(network);
+	}
+
 	// Test nn_Network_inferenceForTraining, scenario: basic
 	{
 		// use previously calculated values (see 2-3-1_example_spreadsheet.ods)
@@ -129,6 +216,197 @@ int main() {
 		nn_Network_free(network);
 	}
 
+	// Test nn_Network_fillUpdates and nn_Network_applyUpdates, scenario: updates from two halves of a batch
+	// add up to the same change as nn_Network_train with the whole batch
+	{
+		nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 0.0,
+			0.0, 1.0
+		);
+		nn_Network *expected = nn_Network_alloc("2, 3, 2");
+		nn_Network_randomiseWeightsBetweenMinAndMax(expected, -1.0, 1.0);
+		nn_Network *network = nn_Network_allocCopy(expected);
+		double expectedError = nn_Network_train(expected, trainingInputs, trainingOutputs, 0.3);
+
+		nn_Matrix *firstInputs = nn_Matrix_allocWithRows(trainingInputs, 0, 2);
+		nn_Matrix *firstOutputs = nn_Matrix_allocWithRows(trainingOutputs, 0, 2);
+		nn_Matrix *secondInputs = nn_Matrix_allocWithRows(trainingInputs, 2, 2);
+		nn_Matrix *secondOutputs = nn_Matrix_allocWithRows(trainingOutputs, 2, 2);
+		nn_Matrix **firstUpdates = nn_Network_allocLayerUpdates(network);
+		nn_Matrix **secondUpdates = nn_Network_allocLayerUpdates(network);
+		double totalCost = nn_Network_fillUpdates(network, firstInputs, firstOutputs, firstUpdates);
+		totalCost += nn_Network_fillUpdates(network, secondInputs, secondOutputs, secondUpdates);
+		assert(fabs(totalCost / 8 - expectedError) < 1e-12);
+		nn_Network_applyUpdates(network, firstUpdates, 0.3 / 4);
+		nn_Network_applyUpdates(network, secondUpdates, 0.3 / 4);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				assert(fabs(network->layerWeights[l]->data[w] - expected->layerWeights[l]->data[w]) < 1e-12);
+			}
+		}
+
+		nn_Network_freeLayerUpdates(network, firstUpdates);
+		nn_Network_freeLayerUpdates(network, secondUpdates);
+		nn_Matrix_free(firstInputs);
+		nn_Matrix_free(firstOutputs);
+		nn_Matrix_free(secondInputs);
+		nn_Matrix_free(secondOutputs);
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+		nn_Network_free(expected);
+	}
+
+	// Test nn_Network_trainWithRecomputation, scenario: same results as nn_Network_train for any interval
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *outputs = nn_Matrix_allocWithValues(4, 1,
+			1.0,
+			0.0,
+			0.0,
+			1.0
+		);
+		nn_Network *network = nn_Network_alloc("2, 4, 5, 3, 4, 2, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -1.0, 1.0, 3);
+		// below 1 is the same as 1
+		for (int checkpointInterval = -1; checkpointInterval <= 7; checkpointInterval++) {
+			nn_Network *recomputed = nn_Network_allocCopy(network);
+			nn_Network *expected = nn_Network_allocCopy(network);
+			for (int step = 0; step < 5; step++) {
+				double cost = nn_Network_trainWithRecomputation(recomputed, inputs, outputs, 2.0, checkpointInterval);
+				assert(cost == nn_Network_train(expected, inputs, outputs, 2.0));
+			}
+			assert(recomputed->layerActivations == NULL);
+			for (int l = 1; l < network->numberOfLayers; l++) {
+				for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+					assert(recomputed->layerWeights[l]->data[w] == expected->layerWeights[l]->data[w]);
+				}
+			}
+			nn_Network_free(expected);
+			nn_Network_free(recomputed);
+		}
+		nn_Network_free(network);
+		nn_Matrix_free(inputs);
+		nn_Matrix_free(outputs);
+	}
+
+	// Test nn_Network_activationBytesForTraining, scenario: fewer checkpoints use less memory
+	{
+		nn_Network *network = nn_Network_alloc("10, 10, 10, 10, 10, 10, 10, 10, 10, 1");
+		// every layer is kept, 8 hidden layers of 10 and 1 output
+		assert(nn_Network_activationBytesForTraining(network, 100, 1) == sizeof(double) * 100 * 81);
+		assert(nn_Network_activationBytesForTraining(network, 100, 0) == sizeof(double) * 100 * 81);
+		// layers 3 and 6, and the outputs, plus a segment of 2 layers
+		assert(nn_Network_activationBytesForTraining(network, 100, 3) == sizeof(double) * 100 * (21 + 20));
+		// only the outputs, plus layers 1 to 8 calculated again at once
+		assert(nn_Network_activationBytesForTraining(network, 100, 9) == sizeof(double) * 100 * (1 + 80));
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_trainWithSparseInputs, scenario: same results as nn_Network_train with dense inputs
+	{
+		nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 6,
+			0.0, 1.0, 0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.0, 1.0, 0.0, 0.0,
+			1.0, 0.0, 0.0, 0.0, 0.0, 0.5,
+			0.0, 1.0, 0.0, 0.0, 0.0, 0.0
+		);
+		nn_SparseMatrix *sparseTrainingInputs = nn_SparseMatrix_allocFromMatrixWithThreshold(trainingInputs, 0.0);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 0.0,
+			0.0, 1.0
+		);
+
+		nn_Network *expected = nn_Network_alloc("6, 3, 2");
+		nn_Network_randomiseWeightsBetweenMinAndMax(expected, -1.0, 1.0);
+		nn_Network *network = nn_Network_alloc("6, 3, 2");
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			memcpy(network->layerWeights[l]->data, expected->layerWeights[l]->data,
+					sizeof(double) * expected->layerWeights[l]->rows * expected->layerWeights[l]->columns);
+		}
+		// row 2 (input index 2) and row 4 are never used, so they must not change
+		double unusedWeight = nn_Matrix_get(network->layerWeights[1], 2, 1);
+
+		for (int i = 0; i < 5; i++) {
+			double expectedError = nn_Network_train(expected, trainingInputs, trainingOutputs, 0.3);
+			double error = nn_Network_trainWithSparseInputs(network, sparseTrainingInputs, trainingOutputs, 0.3);
+			assert(fabs(error - expectedError) < 1e-12);
+		}
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeights = network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+			for (int w = 0; w < numberOfWeights; w++) {
+				assert(fabs(network->layerWeights[l]->data[w] - expected->layerWeights[l]->data[w]) < 1e-12);
+			}
+		}
+		assert(nn_Matrix_get(network->layerWeights[1], 2, 1) == unusedWeight);
+
+		nn_Matrix *outputs = nn_Network_inferenceWithSparseInputs(network, sparseTrainingInputs);
+		nn_Matrix *expectedOutputs = nn_Network_inferenceForTraining(expected, trainingInputs);
+		for (int i = 0; i < 4 * 2; i++) {
+			assert(fabs(outputs->data[i] - expectedOutputs->data[i]) < 1e-12);
+		}
+
+		nn_SparseMatrix_free(sparseTrainingInputs);
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+		nn_Network_free(expected);
+	}
+
+#ifdef __linux__
+	// Test nn_Network_trainWithSparseInputs, scenario: very wide inputs, without memory for the first layer's updates
+	// (Linux only, to read the peak memory)
+	{
+		nn_Network *network = nn_Network_alloc("100000, 64, 1");
+		nn_Matrix_fillWithZeros(network->layerWeights[1]);
+		for (int node = 0; node < 64; node++) {
+			nn_Matrix_set(network->layerWeights[2], node, 0, 1.0);
+		}
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(2, 100000);
+		nn_Matrix_fillWithZeros(trainingInputs);
+		nn_Matrix_set(trainingInputs, 0, 10, 1.0);
+		nn_Matrix_set(trainingInputs, 1, 99999, 1.0);
+		nn_SparseMatrix *sparseTrainingInputs = nn_SparseMatrix_allocFromMatrixWithThreshold(trainingInputs, 0.0);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(2, 1, 1.0, 0.0);
+		for (int i = 0; i < 3; i++) {
+			nn_Network_trainWithSparseInputs(network, sparseTrainingInputs, trainingOutputs, 0.5);
+		}
+		// the most memory ever mapped at once, less what's mapped now, is much less than the first layer's weights
+		long peakKilobytes = 0, sizeKilobytes = 0;
+		char line[256];
+		FILE *status = fopen("/proc/self/status", "r");
+		while (fgets(line, sizeof(line), status) != NULL) {
+			sscanf(line, "VmPeak: %ld", &peakKilobytes);
+			sscanf(line, "VmSize: %ld", &sizeKilobytes);
+		}
+		fclose(status);
+		assert(peakKilobytes > 0 && sizeKilobytes > 0);
+		assert((size_t)(peakKilobytes - sizeKilobytes) * 1024 < sizeof(double) * 100000 * 64 / 2);
+		assert(nn_Matrix_get(network->layerWeights[1], 10, 0) != 0.0);
+		assert(nn_Matrix_get(network->layerWeights[1], 11, 0) == 0.0);
+
+		nn_SparseMatrix_free(sparseTrainingInputs);
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+	}
+#endif
+
 	// Test nn_Network_writeToFile, scenario: basic
 	{
 		nn_Network *network = nn_Network_alloc("2, 3, 2");
@@ -144,7 +422,7 @@ int main() {
 		int writeResult = nn_Network_writeToFile(network, "tmp.nn");
 		assert(writeResult == 0);
 
-		FILE *file = fopen("tmp.nn", "r");
+		FILE *file = fopen("tmp.nn", "rb");
 
 		int numberOfLayers;
 		fread(&numberOfLayers, sizeof(int), 1, file);
@@ -227,7 +505,7 @@ int main() {
 			1.0, -1.0
 		};
 
-		FILE *file = fopen("tmp.nn", "w");
+		FILE *file = fopen("tmp.nn", "wb");
 		fwrite(&numberOfLayers, sizeof(int), 1, file);
 		fwrite(&layer2Rows, sizeof(int), 1, file);
 		fwrite(&layer2Columns, sizeof(int), 1, file);
@@ -260,6 +538,93 @@ int main() {
 		remove("tmp.nn");
 	}
 
+	// Test nn_Network_writeToFileWithPrecision, scenario: unknown precision, the file isn't touched
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		remove("tmp.nn");
+		assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", 3) == NN_ERROR_WRITE_UNKNOWN_PRECISION);
+		assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", -1) == NN_ERROR_WRITE_UNKNOWN_PRECISION);
+		assert(fopen("tmp.nn", "r") == NULL);
+		assert(fopen("tmp.nn.lock", "r") == NULL);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Network_writeToFileWithPrecision, scenario: half precision, rounding and range
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 1.0 / 3.0, 65504.0,
+			1.0e6, pow(2.0, -24), pow(2.0, -26)
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			1.0 + pow(2.0, -11), 1.0 + 3 * pow(2.0, -11),
+			-0.0, 0.1,
+			-1.0e-3, 12345.678
+		);
+		assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", NN_PRECISION_HALF) == 0);
+
+		// a quarter of the size of the doubles, plus the precision of each layer
+		FILE *file = fopen("tmp.nn", "rb");
+		fseek(file, 0, SEEK_END);
+		assert(ftell(file) == sizeof(int) * (1 + 3 * 2) + 2 * 12);
+		fclose(file);
+
+		nn_Network *loaded = nn_Network_allocFromFile("tmp.nn");
+		assert(loaded->numberOfLayers == 3);
+		assert(loaded->numberOfInputs == 2);
+		assert(nn_Matrix_get(loaded->layerWeights[1], 0, 0) == -2.0);
+		assert(fabs(nn_Matrix_get(loaded->layerWeights[1], 0, 1) - 1.0 / 3.0) < 1.0 / 3.0 * pow(2.0, -11));
+		// largest value, too big, smallest value, too small
+		assert(nn_Matrix_get(loaded->layerWeights[1], 0, 2) == 65504.0);
+		assert(isinf(nn_Matrix_get(loaded->layerWeights[1], 1, 0)));
+		assert(nn_Matrix_get(loaded->layerWeights[1], 1, 1) == pow(2.0, -24));
+		assert(nn_Matrix_get(loaded->layerWeights[1], 1, 2) == 0.0);
+		// halfway between two values rounds to the even one
+		assert(nn_Matrix_get(loaded->layerWeights[2], 0, 0) == 1.0);
+		assert(nn_Matrix_get(loaded->layerWeights[2], 0, 1) == 1.0 + pow(2.0, -9));
+		assert(nn_Matrix_get(loaded->layerWeights[2], 1, 0) == 0.0);
+		assert(signbit(nn_Matrix_get(loaded->layerWeights[2], 1, 0)));
+		for (int w = 3; w < 6; w++) {
+			double weight = network->layerWeights[2]->data[w];
+			assert(fabs(loaded->layerWeights[2]->data[w] - weight) <= fabs(weight) * pow(2.0, -11));
+		}
+		nn_Network_free(loaded);
+		nn_Network_free(network);
+		remove("tmp.nn");
+	}
+
+	// Test nn_Network_writeToFileWithPrecision, scenario: bfloat16, and trained weights
+	{
+		nn_Network *network = nn_Network_alloc("20, 30, 2");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -3.0, 3.0, 5);
+		nn_Matrix_set(network->layerWeights[1], 0, 0, 1.0e30);
+		nn_Matrix_set(network->layerWeights[1], 0, 1, 1.5);
+		assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", NN_PRECISION_BFLOAT16) == 0);
+		nn_Network *loaded = nn_Network_allocFromFile("tmp.nn");
+		assert(nn_Matrix_get(loaded->layerWeights[1], 0, 1) == 1.5);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				double weight = network->layerWeights[l]->data[w];
+				assert(fabs(loaded->layerWeights[l]->data[w] - weight) <= fabs(weight) * pow(2.0, -8));
+			}
+		}
+		nn_Network_free(loaded);
+
+		// half precision, enough weights for the vectorised widening
+		assert(nn_Network_writeToFileWithPrecision(network, "tmp.nn", NN_PRECISION_HALF) == 0);
+		loaded = nn_Network_allocFromFile("tmp.nn");
+		assert(isinf(nn_Matrix_get(loaded->layerWeights[1], 0, 0)));
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			for (int w = 1; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+				double weight = network->layerWeights[l]->data[w];
+				assert(fabs(loaded->layerWeights[l]->data[w] - weight) <= fabs(weight) * pow(2.0, -11));
+			}
+		}
+		nn_Network_free(loaded);
+		nn_Network_free(network);
+		remove("tmp.nn");
+	}
+
 	// Test nn_Network_allocFromFile, scenario: don't read if there's a .lock file
 	{
 		FILE *lock = fopen("tmp.nn.lock", "w");
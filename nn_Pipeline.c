@@ -0,0 +1,242 @@
+#include <stdlib.h>	// malloc, calloc, free
+#include <sched.h>	// sched_yield
+#include <pthread.h>	// pthread_create, pthread_join
+
+#include "nn_Pipeline.h"
+
+// Pipeline parallel training. The layers of the network are split into consecutive ranges ("stages"), each run
+// by its own thread, so each thread only ever touches its own stage's weights. A batch is split into
+// micro-batches which flow forwards through all the stages, then backwards in reverse order (like GPipe).
+// Updates are summed over all micro-batches and applied at the end, so one call to nn_Pipeline_train changes
+// the weights the same way as one call to nn_Network_train with the whole batch.
+
+// 'private' functions
+void nn_Pipeline__push(nn_PipelineQueue *queue, int microBatch, nn_Matrix *matrix);
+nn_PipelineMessage nn_Pipeline__pop(nn_PipelineQueue *queue);
+void *nn_Pipeline__runStage(void *stage);
+void nn_Pipeline__trainStage(nn_PipelineStage *this, nn_PipelineMessage firstMessage);
+
+nn_Pipeline *nn_Pipeline_alloc(nn_Network *network, int numberOfStages) {
+	nn_Pipeline *this = malloc(sizeof(nn_Pipeline));
+	this->network = network;
+	// can't have more stages than there are layers with weights
+	if (numberOfStages > network->numberOfLayers - 1) {
+		numberOfStages = network->numberOfLayers - 1;
+	}
+	this->numberOfStages = numberOfStages;
+	this->stages = malloc(sizeof(nn_PipelineStage) * numberOfStages);
+
+	// Queues are: one into each stage going forwards, one out of each stage (except the first) going backwards,
+	// and one out of each stage to say it's done.
+	this->queues = calloc(numberOfStages * 3, sizeof(nn_PipelineQueue));
+	nn_PipelineQueue *forwardQueues = this->queues;
+	nn_PipelineQueue *backwardQueues = this->queues + numberOfStages;
+	nn_PipelineQueue *doneQueues = this->queues + numberOfStages * 2;
+
+	// Split the layers so each stage has roughly the same number of weights
+	int totalWeights = 0;
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		totalWeights += network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+	}
+	int layer = 1;
+	int weightsSoFar = 0;
+	for (int s = 0; s < numberOfStages; s++) {
+		nn_PipelineStage *stage = &this->stages[s];
+		stage->pipeline = this;
+		stage->firstLayer = layer;
+		int targetWeights = (long)totalWeights * (s + 1) / numberOfStages;
+		int layersLeftForOtherStages = numberOfStages - s - 1;
+		do {
+			weightsSoFar += network->layerWeights[layer]->rows * network->layerWeights[layer]->columns;
+			layer++;
+		} while (weightsSoFar < targetWeights && network->numberOfLayers - layer > layersLeftForOtherStages);
+		stage->lastLayer = layer - 1;
+
+		stage->forwardIn = &forwardQueues[s];
+		stage->forwardOut = s < numberOfStages - 1 ? &forwardQueues[s + 1] : NULL;
+		stage->backwardIn = s < numberOfStages - 1 ? &backwardQueues[s + 1] : NULL;
+		stage->backwardOut = s > 0 ? &backwardQueues[s] : NULL;
+		stage->done = &doneQueues[s];
+		stage->microBatchActivations = NULL;
+		stage->layerUpdates = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+		for (int l = stage->firstLayer; l <= stage->lastLayer; l++) {
+			stage->layerUpdates[l] = nn_Matrix_alloc(network->layerWeights[l]->rows, network->layerWeights[l]->columns);
+		}
+	}
+
+	for (int s = 0; s < numberOfStages; s++) {
+		pthread_create(&this->stages[s].thread, NULL, nn_Pipeline__runStage, &this->stages[s]);
+	}
+	return this;
+}
+
+void nn_Pipeline_free(nn_Pipeline *this) {
+	// A negative micro-batch tells each stage to pass the message on and stop
+	nn_Pipeline__push(this->stages[0].forwardIn, -1, NULL);
+	for (int s = 0; s < this->numberOfStages; s++) {
+		nn_PipelineStage *stage = &this->stages[s];
+		pthread_join(stage->thread, NULL);
+		for (int l = stage->firstLayer; l <= stage->lastLayer; l++) {
+			nn_Matrix_free(stage->layerUpdates[l]);
+		}
+		free(stage->layerUpdates);
+	}
+	free(this->queues);
+	free(this->stages);
+	free(this);
+}
+
+double nn_Pipeline_train(nn_Pipeline *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		int numberOfMicroBatches, double trainingIncrement) {
+	if (numberOfMicroBatches > trainingDataInputs->rows) {
+		numberOfMicroBatches = trainingDataInputs->rows;
+	}
+	// Split the batch up, the inputs go to the first stage and the outputs are used by the last stage.
+	nn_Matrix **microBatchInputs = malloc(sizeof(nn_Matrix *) * numberOfMicroBatches);
+	this->microBatchOutputs = malloc(sizeof(nn_Matrix *) * numberOfMicroBatches);
+	for (int m = 0; m < numberOfMicroBatches; m++) {
+		int firstRow = trainingDataInputs->rows * m / numberOfMicroBatches;
+		int numberOfRows = trainingDataInputs->rows * (m + 1) / numberOfMicroBatches - firstRow;
+		microBatchInputs[m] = nn_Matrix_allocWithRows(trainingDataInputs, firstRow, numberOfRows);
+		this->microBatchOutputs[m] = nn_Matrix_allocWithRows(trainingDataOutputs, firstRow, numberOfRows);
+	}
+	this->numberOfMicroBatches = numberOfMicroBatches;
+	this->numberOfExamples = trainingDataInputs->rows;
+	this->trainingIncrement = trainingIncrement;
+
+	for (int m = 0; m < numberOfMicroBatches; m++) {
+		nn_Pipeline__push(this->stages[0].forwardIn, m, microBatchInputs[m]);
+	}
+	for (int s = 0; s < this->numberOfStages; s++) {
+		nn_Pipeline__pop(this->stages[s].done);
+	}
+
+	for (int m = 0; m < numberOfMicroBatches; m++) {
+		nn_Matrix_free(microBatchInputs[m]);
+		nn_Matrix_free(this->microBatchOutputs[m]);
+	}
+	free(microBatchInputs);
+	free(this->microBatchOutputs);
+
+	return this->stages[this->numberOfStages - 1].totalCost / (trainingDataOutputs->rows * trainingDataOutputs->columns);
+}
+
+void nn_Pipeline__push(nn_PipelineQueue *queue, int microBatch, nn_Matrix *matrix) {
+	int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	// wait while the queue is full
+	while (tail - atomic_load_explicit(&queue->head, memory_order_acquire) == NN_PIPELINE_QUEUE_CAPACITY) {
+		sched_yield();
+	}
+	nn_PipelineMessage *message = &queue->messages[tail % NN_PIPELINE_QUEUE_CAPACITY];
+	message->microBatch = microBatch;
+	message->matrix = matrix;
+	atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+}
+
+nn_PipelineMessage nn_Pipeline__pop(nn_PipelineQueue *queue) {
+	int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	// wait while the queue is empty
+	while (atomic_load_explicit(&queue->tail, memory_order_acquire) == head) {
+		sched_yield();
+	}
+	nn_PipelineMessage message = queue->messages[head % NN_PIPELINE_QUEUE_CAPACITY];
+	atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+	return message;
+}
+
+void *nn_Pipeline__runStage(void *stage) {
+	nn_PipelineStage *this = stage;
+	while (1) {
+		nn_PipelineMessage message = nn_Pipeline__pop(this->forwardIn);
+		if (message.microBatch < 0) {
+			if (this->forwardOut != NULL) {
+				nn_Pipeline__push(this->forwardOut, -1, NULL);
+			}
+			return NULL;
+		}
+		nn_Pipeline__trainStage(this, message);
+	}
+}
+
+// Runs one training pass for this stage, `firstMessage` has already been taken off the forwards queue.
+void nn_Pipeline__trainStage(nn_PipelineStage *this, nn_PipelineMessage firstMessage) {
+	nn_Pipeline *pipeline = this->pipeline;
+	nn_Network *network = pipeline->network;
+	int numberOfMicroBatches = pipeline->numberOfMicroBatches;
+
+	for (int l = this->firstLayer; l <= this->lastLayer; l++) {
+		nn_Matrix_fillWithZeros(this->layerUpdates[l]);
+	}
+	this->totalCost = 0.0;
+
+	// Forwards, keeping the activations of every micro-batch for the backward pass.
+	// Index firstLayer - 1 holds the activations received from the previous stage.
+	this->microBatchActivations = malloc(sizeof(nn_Matrix **) * numberOfMicroBatches);
+	for (int m = 0; m < numberOfMicroBatches; m++) {
+		nn_PipelineMessage message = m == 0 ? firstMessage : nn_Pipeline__pop(this->forwardIn);
+		nn_Matrix **activations = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+		this->microBatchActivations[message.microBatch] = activations;
+		activations[this->firstLayer - 1] = message.matrix;
+		for (int l = this->firstLayer; l <= this->lastLayer; l++) {
+			activations[l] = nn_Matrix_alloc(message.matrix->rows, network->layerWeights[l]->columns);
+			nn_Network_fillActivationsAtLayer(network, l, activations[l], activations[l - 1]);
+		}
+		if (this->forwardOut != NULL) {
+			nn_Pipeline__push(this->forwardOut, message.microBatch, activations[this->lastLayer]);
+		}
+	}
+
+	// Backwards, in reverse order so the most recently used activations are used first
+	for (int m = numberOfMicroBatches - 1; m >= 0; m--) {
+		nn_Matrix **activations = this->microBatchActivations[m];
+		nn_Matrix *deltas = nn_Matrix_alloc(activations[this->lastLayer]->rows, activations[this->lastLayer]->columns);
+		if (this->backwardIn == NULL) {
+			this->totalCost += nn_Network_fillOutputDeltas(network, deltas, activations[this->lastLayer],
+					pipeline->microBatchOutputs[m]);
+		}
+		else {
+			nn_PipelineMessage message = nn_Pipeline__pop(this->backwardIn);
+			nn_Network_fillHiddenDeltas(network, deltas, message.matrix, activations[this->lastLayer]);
+			nn_Matrix_free(message.matrix);
+		}
+		for (int l = this->lastLayer; l >= this->firstLayer; l--) {
+			nn_Matrix_addDotProductTransposingA(this->layerUpdates[l], activations[l - 1], deltas);
+			if (l == 1) {
+				break;
+			}
+			nn_Matrix *errors = nn_Matrix_alloc(activations[l - 1]->rows, activations[l - 1]->columns);
+			nn_Network_fillErrorsBelowLayer(network, l, errors, deltas);
+			nn_Matrix_free(deltas);
+			deltas = errors;
+			if (l == this->firstLayer) {
+				// the previous stage turns these errors into deltas, and owns them from now on
+				nn_Pipeline__push(this->backwardOut, m, errors);
+				deltas = NULL;
+			}
+			else {
+				nn_Network_fillHiddenDeltas(network, deltas, errors, activations[l - 1]);
+			}
+		}
+		if (deltas != NULL) {
+			nn_Matrix_free(deltas);
+		}
+	}
+
+	// Every micro-batch has been through every stage, so the updates can be applied
+	for (int l = this->firstLayer; l <= this->lastLayer; l++) {
+		nn_Network_applyUpdatesAtLayer(network, l, this->layerUpdates[l],
+				pipeline->trainingIncrement / pipeline->numberOfExamples);
+	}
+
+	// The activations received from the previous stage belong to that stage
+	for (int m = 0; m < numberOfMicroBatches; m++) {
+		for (int l = this->firstLayer; l <= this->lastLayer; l++) {
+			nn_Matrix_free(this->microBatchActivations[m][l]);
+		}
+		free(this->microBatchActivations[m]);
+	}
+	free(this->microBatchActivations);
+	this->microBatchActivations = NULL;
+
+	nn_Pipeline__push(this->done, 0, NULL);
+}
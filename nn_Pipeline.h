@@ -0,0 +1,62 @@
+#ifndef __NN_PIPELINE_H__
+#define __NN_PIPELINE_H__
+
+
+#include <pthread.h>	// pthread_t
+#include <stdatomic.h>	// atomic_int
+
+#include "nn_Network.h"
+
+#define NN_PIPELINE_QUEUE_CAPACITY	64
+
+// A message passed between stages, either activations going forwards or errors going backwards.
+typedef struct {
+	int microBatch;
+	nn_Matrix *matrix;
+} nn_PipelineMessage;
+
+// Single producer, single consumer queue. Only the producer moves `tail` and only the consumer moves `head`,
+// so no locks are needed.
+typedef struct {
+	nn_PipelineMessage messages[NN_PIPELINE_QUEUE_CAPACITY];
+	atomic_int head;
+	atomic_int tail;
+} nn_PipelineQueue;
+
+typedef struct nn_Pipeline nn_Pipeline;
+
+typedef struct {
+	nn_Pipeline *pipeline;
+	int firstLayer;
+	int lastLayer;
+	pthread_t thread;
+	nn_PipelineQueue *forwardIn;	// from the previous stage (or from nn_Pipeline_train for the first stage)
+	nn_PipelineQueue *forwardOut;	// NULL for the last stage
+	nn_PipelineQueue *backwardIn;	// NULL for the last stage
+	nn_PipelineQueue *backwardOut;	// NULL for the first stage
+	nn_PipelineQueue *done;	// tells nn_Pipeline_train this stage has applied its updates
+	nn_Matrix ***microBatchActivations;	// [microBatch][layer]
+	nn_Matrix **layerUpdates;
+	double totalCost;	// only used by the last stage
+} nn_PipelineStage;
+
+struct nn_Pipeline {
+	nn_Network *network;
+	int numberOfStages;
+	nn_PipelineStage *stages;
+	nn_PipelineQueue *queues;
+	// Set by nn_Pipeline_train before any micro-batches are sent to the first stage
+	int numberOfMicroBatches;
+	int numberOfExamples;
+	nn_Matrix **microBatchOutputs;
+	double trainingIncrement;
+};
+
+nn_Pipeline *nn_Pipeline_alloc(nn_Network *network, int numberOfStages);
+void nn_Pipeline_free(nn_Pipeline *this);
+
+double nn_Pipeline_train(nn_Pipeline *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs,
+		int numberOfMicroBatches, double trainingIncrement);
+
+
+#endif
@@ -0,0 +1,113 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "nn_Pipeline.h"
+
+int main() {
+	// Test nn_Pipeline_alloc, scenario: layers are split between stages
+	{
+		nn_Network *network = nn_Network_alloc("4, 8, 8, 8, 2");
+		nn_Pipeline *pipeline = nn_Pipeline_alloc(network, 3);
+		assert(pipeline->numberOfStages == 3);
+		assert(pipeline->stages[0].firstLayer == 1);
+		assert(pipeline->stages[2].lastLayer == 4);
+		for (int s = 1; s < pipeline->numberOfStages; s++) {
+			assert(pipeline->stages[s].firstLayer == pipeline->stages[s - 1].lastLayer + 1);
+			assert(pipeline->stages[s].firstLayer <= pipeline->stages[s].lastLayer);
+		}
+		nn_Pipeline_free(pipeline);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Pipeline_alloc, scenario: more stages than layers
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Pipeline *pipeline = nn_Pipeline_alloc(network, 8);
+		assert(pipeline->numberOfStages == 2);
+		nn_Pipeline_free(pipeline);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Pipeline_train, scenario: same results as nn_Network_train (see 2-3-2_example_spreadsheet.ods)
+	{
+		nn_Matrix *trainingInputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *trainingOutputs = nn_Matrix_allocWithValues(4, 2,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 0.0,
+			0.0, 1.0
+		);
+
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0, 2.0,
+			0.0, -2.0,
+			1.0, -1.0
+		);
+		nn_Pipeline *pipeline = nn_Pipeline_alloc(network, 2);
+		double error = nn_Pipeline_train(pipeline, trainingInputs, trainingOutputs, 3, 0.3);
+		assert(error > 0.280 && error < 0.281);
+
+		assert(nn_Matrix_get(network->layerWeights[1], 0, 1) > -0.005 && nn_Matrix_get(network->layerWeights[1], 0, 1) < -0.004);
+		assert(nn_Matrix_get(network->layerWeights[1], 1, 2) > -2.007 && nn_Matrix_get(network->layerWeights[1], 1, 2) < -2.006);
+		assert(nn_Matrix_get(network->layerWeights[2], 0, 1) > 2.009 && nn_Matrix_get(network->layerWeights[2], 0, 1) < 2.010);
+		assert(nn_Matrix_get(network->layerWeights[2], 2, 0) > 0.991 && nn_Matrix_get(network->layerWeights[2], 2, 0) < 0.992);
+
+		nn_Pipeline_free(pipeline);
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Pipeline_train, scenario: deeper network, repeated training matches nn_Network_train
+	{
+		char *layout = "3, 5, 4, 6, 2";
+		nn_Network *expected = nn_Network_alloc(layout);
+		nn_Network_randomiseWeightsBetweenMinAndMax(expected, -1.0, 1.0);
+		nn_Network *network = nn_Network_alloc(layout);
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			memcpy(network->layerWeights[l]->data, expected->layerWeights[l]->data,
+					sizeof(double) * expected->layerWeights[l]->rows * expected->layerWeights[l]->columns);
+		}
+		nn_Matrix *trainingInputs = nn_Matrix_alloc(7, 3);
+		nn_Matrix *trainingOutputs = nn_Matrix_alloc(7, 2);
+		for (int i = 0; i < 7 * 3; i++) {
+			trainingInputs->data[i] = (i % 5) / 4.0;
+		}
+		for (int i = 0; i < 7 * 2; i++) {
+			trainingOutputs->data[i] = (i % 3) / 2.0;
+		}
+
+		nn_Pipeline *pipeline = nn_Pipeline_alloc(network, 3);
+		for (int i = 0; i < 20; i++) {
+			double expectedError = nn_Network_train(expected, trainingInputs, trainingOutputs, 0.5);
+			double error = nn_Pipeline_train(pipeline, trainingInputs, trainingOutputs, 3, 0.5);
+			assert(fabs(error - expectedError) < 1e-12);
+		}
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			int numberOfWeights = network->layerWeights[l]->rows * network->layerWeights[l]->columns;
+			for (int w = 0; w < numberOfWeights; w++) {
+				assert(fabs(network->layerWeights[l]->data[w] - expected->layerWeights[l]->data[w]) < 1e-12);
+			}
+		}
+
+		nn_Pipeline_free(pipeline);
+		nn_Matrix_free(trainingInputs);
+		nn_Matrix_free(trainingOutputs);
+		nn_Network_free(network);
+		nn_Network_free(expected);
+	}
+
+	return 0;
+}
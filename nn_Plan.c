@@ -0,0 +1,281 @@
+#include <stdlib.h>	// malloc, free
+#include <string.h>	// strcmp, strncmp, strcpy, strncpy, strchr, strlen, memcpy
+#include <stdio.h>	// fopen, fgets, fprintf, sscanf, sprintf
+#include <time.h>	// clock_gettime
+#ifdef __APPLE__
+#include <sys/sysctl.h>	// sysctlbyname
+#endif
+
+#include "nn_Plan.h"
+
+// Tunes the dot product at each layer for this machine. Which kernel is fastest, and how many threads are
+// worth waking up for a layer, depends on the shape of the layer, the batch size and the CPU (e.g. a 2x3 layer
+// is fastest unblocked on one thread, a 4096x1024 layer blocked across all of them), so each layer is timed
+// with every candidate. Tuning takes a while, so the plan is saved to a file to be loaded at startup.
+//
+// File format is text:
+// - CPU model
+// - numberOfExamples numberOfThreads numberOfLayers
+// for each layer, except input layer (i.e. numberOfLayers - 1)
+// - rows columns blockSize threads
+
+// Candidate kernel block sizes, 0 is the unblocked kernel
+static int nn_Plan__blockSizes[] = { 0, 8, 32, 128, 512 };
+#define NN_PLAN_NUMBER_OF_BLOCK_SIZES	(int)(sizeof(nn_Plan__blockSizes) / sizeof(int))
+// Each candidate is run enough times to do at least this many multiply-adds, then the fastest of a few runs is kept
+#define NN_PLAN_MINIMUM_MULTIPLY_ADDS	1000000
+#define NN_PLAN_TIMING_RUNS	3
+
+// 'private' functions
+nn_Plan *nn_Plan__alloc(nn_Network *network, int numberOfExamples, int numberOfThreads);
+void nn_Plan__tuneLayer(nn_Plan *this, nn_Network *network, int layer, nn_ThreadTeam *team);
+double nn_Plan__secondsForInference(nn_ThreadTeam *team, nn_Network *network, nn_Matrix *inputs, int iterations);
+void nn_Plan__fillCPUModel(char *cpuModel);
+
+// Times every candidate at each layer of `network`, with `numberOfExamples` rows of inputs and up to `numberOfThreads` threads.
+// A `numberOfThreads` below 1 is taken as 1.
+nn_Plan *nn_Plan_allocByTuning(nn_Network *network, int numberOfExamples, int numberOfThreads) {
+	if (numberOfThreads < 1) {
+		numberOfThreads = 1;
+	}
+	nn_Plan *this = nn_Plan__alloc(network, numberOfExamples, numberOfThreads);
+	nn_Plan__fillCPUModel(this->cpuModel);
+	nn_ThreadTeam *team = nn_ThreadTeam_alloc(numberOfThreads);
+	team->layerThreads = malloc(sizeof(int) * 2);
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		nn_Plan__tuneLayer(this, network, l, team);
+	}
+	nn_ThreadTeam_free(team);
+	return this;
+}
+
+// Returns NULL if the file can't be read, or the plan in it wasn't made on this CPU model for the same shapes.
+nn_Plan *nn_Plan_allocFromFile(char *filename, nn_Network *network, int numberOfExamples, int numberOfThreads) {
+	FILE *file = fopen(filename, "r");
+	if (file == NULL) {
+		return NULL;
+	}
+	char line[NN_PLAN_CPU_MODEL_LENGTH];
+	int fileNumberOfExamples, fileNumberOfThreads, fileNumberOfLayers;
+	if (fgets(line, NN_PLAN_CPU_MODEL_LENGTH, file) == NULL ||
+			fscanf(file, "%d %d %d", &fileNumberOfExamples, &fileNumberOfThreads, &fileNumberOfLayers) != 3 ||
+			fileNumberOfLayers != network->numberOfLayers) {
+		fclose(file);
+		return NULL;
+	}
+	nn_Plan *this = nn_Plan__alloc(network, fileNumberOfExamples, fileNumberOfThreads);
+	char *newline = strchr(line, '\n');
+	if (newline != NULL) {
+		*newline = '\0';
+	}
+	strncpy(this->cpuModel, line, NN_PLAN_CPU_MODEL_LENGTH);
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		if (fscanf(file, "%d %d %d %d", &this->layerRows[l], &this->layerColumns[l], &this->layerBlockSizes[l],
+				&this->layerThreads[l]) != 4) {
+			fclose(file);
+			nn_Plan_free(this);
+			return NULL;
+		}
+	}
+	fclose(file);
+
+	if (!nn_Plan_matches(this, network, numberOfExamples, numberOfThreads)) {
+		nn_Plan_free(this);
+		return NULL;
+	}
+	return this;
+}
+
+// Loads the plan from `filename` if there's one for this machine and network, otherwise tunes and saves a new one.
+// A `numberOfThreads` below 1 is taken as 1, the same as nn_Plan_allocByTuning.
+nn_Plan *nn_Plan_allocForNetwork(nn_Network *network, int numberOfExamples, int numberOfThreads, char *filename) {
+	if (numberOfThreads < 1) {
+		numberOfThreads = 1;
+	}
+	nn_Plan *this = nn_Plan_allocFromFile(filename, network, numberOfExamples, numberOfThreads);
+	if (this == NULL) {
+		this = nn_Plan_allocByTuning(network, numberOfExamples, numberOfThreads);
+		nn_Plan_writeToFile(this, filename);
+	}
+	return this;
+}
+
+void nn_Plan_free(nn_Plan *this) {
+	free(this->layerRows);
+	free(this->layerColumns);
+	free(this->layerBlockSizes);
+	free(this->layerThreads);
+	free(this);
+}
+
+// Whether the plan was made on this CPU model, for a network with the same shapes, and the same batch size and threads.
+bool nn_Plan_matches(nn_Plan *this, nn_Network *network, int numberOfExamples, int numberOfThreads) {
+	char cpuModel[NN_PLAN_CPU_MODEL_LENGTH];
+	nn_Plan__fillCPUModel(cpuModel);
+	if (strcmp(this->cpuModel, cpuModel) != 0 || this->numberOfExamples != numberOfExamples ||
+			this->numberOfThreads != numberOfThreads || this->numberOfLayers != network->numberOfLayers) {
+		return false;
+	}
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		if (this->layerRows[l] != network->layerWeights[l]->rows || this->layerColumns[l] != network->layerWeights[l]->columns) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Training and inference with `network` use the block sizes from the plan from now on. Returns false, and leaves
+// `network` as it was, if the plan is for a different number of layers.
+bool nn_Plan_applyToNetwork(nn_Plan *this, nn_Network *network) {
+	if (this->numberOfLayers != network->numberOfLayers) {
+		return false;
+	}
+	if (network->layerBlockSizes == NULL) {
+		network->layerBlockSizes = malloc(sizeof(int) * network->numberOfLayers);
+	}
+	memcpy(network->layerBlockSizes, this->layerBlockSizes, sizeof(int) * network->numberOfLayers);
+	return true;
+}
+
+// `team` uses the number of threads for each layer from the plan, for networks with the same shapes.
+void nn_Plan_applyToThreadTeam(nn_Plan *this, nn_ThreadTeam *team) {
+	free(team->layerThreads);
+	team->layerThreads = malloc(sizeof(int) * this->numberOfLayers);
+	memcpy(team->layerThreads, this->layerThreads, sizeof(int) * this->numberOfLayers);
+}
+
+// Returns 0 on success, or NN_ERROR_WRITE_FOPEN_FAIL.
+int nn_Plan_writeToFile(nn_Plan *this, char *filename) {
+	FILE *file = fopen(filename, "w");
+	if (file == NULL) {
+		printf("Error opening file '%s' to write plan to.\n", filename);
+		return NN_ERROR_WRITE_FOPEN_FAIL;
+	}
+	fprintf(file, "%s\n", this->cpuModel);
+	fprintf(file, "%d %d %d\n", this->numberOfExamples, this->numberOfThreads, this->numberOfLayers);
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		fprintf(file, "%d %d %d %d\n", this->layerRows[l], this->layerColumns[l], this->layerBlockSizes[l], this->layerThreads[l]);
+	}
+	fclose(file);
+	return 0;
+}
+
+// Allocates a plan for the shapes of `network`, with every layer unblocked on one thread.
+nn_Plan *nn_Plan__alloc(nn_Network *network, int numberOfExamples, int numberOfThreads) {
+	nn_Plan *this = malloc(sizeof(nn_Plan));
+	this->cpuModel[0] = '\0';
+	this->numberOfExamples = numberOfExamples;
+	this->numberOfThreads = numberOfThreads;
+	this->numberOfLayers = network->numberOfLayers;
+	this->layerRows = malloc(sizeof(int) * this->numberOfLayers);
+	this->layerColumns = malloc(sizeof(int) * this->numberOfLayers);
+	this->layerBlockSizes = malloc(sizeof(int) * this->numberOfLayers);
+	this->layerThreads = malloc(sizeof(int) * this->numberOfLayers);
+	this->layerRows[0] = this->layerColumns[0] = this->layerBlockSizes[0] = this->layerThreads[0] = 0;
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		this->layerRows[l] = network->layerWeights[l]->rows;
+		this->layerColumns[l] = network->layerWeights[l]->columns;
+		this->layerBlockSizes[l] = 0;
+		this->layerThreads[l] = 1;
+	}
+	return this;
+}
+
+// Times the layer on its own, as a network with just that layer, for every block size and number of threads.
+void nn_Plan__tuneLayer(nn_Plan *this, nn_Network *network, int layer, nn_ThreadTeam *team) {
+	int rows = network->layerWeights[layer]->rows;
+	int columns = network->layerWeights[layer]->columns;
+	char layout[32];
+	sprintf(layout, "%d, %d", rows, columns);
+	nn_Network *layerNetwork = nn_Network_alloc(layout);
+	memcpy(layerNetwork->layerWeights[1]->data, network->layerWeights[layer]->data, sizeof(double) * rows * columns);
+	layerNetwork->layerBlockSizes = malloc(sizeof(int) * 2);
+
+	nn_Matrix *inputs = nn_Matrix_alloc(this->numberOfExamples, rows);
+	for (int i = 0; i < this->numberOfExamples * rows; i++) {
+		inputs->data[i] = (i % 7) / 7.0;
+	}
+	double multiplyAdds = (double)this->numberOfExamples * rows * columns;
+	int iterations = multiplyAdds >= NN_PLAN_MINIMUM_MULTIPLY_ADDS ? 1 : (int)(NN_PLAN_MINIMUM_MULTIPLY_ADDS / multiplyAdds);
+
+	// 1, 2, 4 ... threads, and all of them, but not more threads than nodes
+	int threadCounts[32];
+	int numberOfThreadCounts = 0;
+	for (int threads = 1; threads <= this->numberOfThreads && threads <= columns; threads *= 2) {
+		threadCounts[numberOfThreadCounts++] = threads;
+	}
+	if (this->numberOfThreads <= columns && threadCounts[numberOfThreadCounts - 1] != this->numberOfThreads) {
+		threadCounts[numberOfThreadCounts++] = this->numberOfThreads;
+	}
+
+	double fastestSeconds = -1.0;
+	for (int b = 0; b < NN_PLAN_NUMBER_OF_BLOCK_SIZES; b++) {
+		// blocks bigger than the layer are all the same as one block
+		if (b > 1 && nn_Plan__blockSizes[b - 1] >= columns) {
+			break;
+		}
+		layerNetwork->layerBlockSizes[1] = nn_Plan__blockSizes[b];
+		for (int t = 0; t < numberOfThreadCounts; t++) {
+			team->layerThreads[1] = threadCounts[t];
+			double seconds = nn_Plan__secondsForInference(team, layerNetwork, inputs, iterations);
+			if (fastestSeconds < 0.0 || seconds < fastestSeconds) {
+				fastestSeconds = seconds;
+				this->layerBlockSizes[layer] = nn_Plan__blockSizes[b];
+				this->layerThreads[layer] = threadCounts[t];
+			}
+		}
+	}
+
+	nn_Matrix_free(inputs);
+	nn_Network_free(layerNetwork);
+}
+
+// The fastest of a few runs of `iterations` inferences.
+double nn_Plan__secondsForInference(nn_ThreadTeam *team, nn_Network *network, nn_Matrix *inputs, int iterations) {
+	double fastestSeconds = -1.0;
+	for (int run = 0; run < NN_PLAN_TIMING_RUNS; run++) {
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < iterations; i++) {
+			nn_Matrix_free(nn_ThreadTeam_inference(team, network, inputs));
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		if (fastestSeconds < 0.0 || seconds < fastestSeconds) {
+			fastestSeconds = seconds;
+		}
+	}
+	return fastestSeconds;
+}
+
+// e.g. "Intel(R) Xeon(R) Platinum 8375C CPU @ 2.90GHz", or "unknown" if it can't be found.
+void nn_Plan__fillCPUModel(char *cpuModel) {
+	strcpy(cpuModel, "unknown");
+#ifdef __APPLE__
+	size_t length = NN_PLAN_CPU_MODEL_LENGTH;
+	sysctlbyname("machdep.cpu.brand_string", cpuModel, &length, NULL, 0);
+#else
+	FILE *file = fopen("/proc/cpuinfo", "r");
+	if (file == NULL) {
+		return;
+	}
+	char line[NN_PLAN_CPU_MODEL_LENGTH];
+	while (fgets(line, NN_PLAN_CPU_MODEL_LENGTH, file) != NULL) {
+		if (strncmp(line, "model name", strlen("model name")) == 0) {
+			char *value = strchr(line, ':');
+			if (value != NULL) {
+				// skip ": "
+				value += value[1] == ' ' ? 2 : 1;
+				strncpy(cpuModel, value, NN_PLAN_CPU_MODEL_LENGTH - 1);
+				cpuModel[NN_PLAN_CPU_MODEL_LENGTH - 1] = '\0';
+				char *newline = strchr(cpuModel, '\n');
+				if (newline != NULL) {
+					*newline = '\0';
+				}
+			}
+			break;
+		}
+	}
+	fclose(file);
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef __NN_PLAN_H__
+#define __NN_PLAN_H__
+
+
+#include <stdbool.h>	// bool, true, false
+
+#include "nn_Network.h"
+#include "nn_ThreadTeam.h"
+
+#define NN_PLAN_CPU_MODEL_LENGTH	256
+
+// The fastest kernel block size and number of threads for each layer of a network, measured on this machine
+// for a batch size. Plans are only used with the CPU model and shapes they were measured for.
+typedef struct {
+	char cpuModel[NN_PLAN_CPU_MODEL_LENGTH];
+	int numberOfExamples;
+	int numberOfThreads;	// the most threads any layer can use
+	int numberOfLayers;
+	// index 0 is unused, like layerWeights in nn_Network
+	int *layerRows;
+	int *layerColumns;
+	int *layerBlockSizes;	// 0 is the unblocked kernel
+	int *layerThreads;
+} nn_Plan;
+
+nn_Plan *nn_Plan_allocByTuning(nn_Network *network, int numberOfExamples, int numberOfThreads);
+nn_Plan *nn_Plan_allocFromFile(char *filename, nn_Network *network, int numberOfExamples, int numberOfThreads);
+nn_Plan *nn_Plan_allocForNetwork(nn_Network *network, int numberOfExamples, int numberOfThreads, char *filename);
+void nn_Plan_free(nn_Plan *this);
+
+bool nn_Plan_matches(nn_Plan *this, nn_Network *network, int numberOfExamples, int numberOfThreads);
+bool nn_Plan_applyToNetwork(nn_Plan *this, nn_Network *network);
+void nn_Plan_applyToThreadTeam(nn_Plan *this, nn_ThreadTeam *team);
+
+int nn_Plan_writeToFile(nn_Plan *this, char *filename);
+
+
+#endif
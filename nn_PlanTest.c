@@ -0,0 +1,141 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "nn_Plan.h"
+
+int main() {
+	// Test nn_Plan_allocByTuning, scenario: a choice for every layer, and the same outputs once applied
+	{
+		nn_Network *network = nn_Network_alloc("20, 300, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -1.0, 1.0, 1);
+		nn_Plan *plan = nn_Plan_allocByTuning(network, 8, 2);
+		assert(strlen(plan->cpuModel) > 0);
+		assert(plan->numberOfExamples == 8);
+		assert(plan->numberOfThreads == 2);
+		assert(plan->numberOfLayers == 4);
+		for (int l = 1; l < 4; l++) {
+			assert(plan->layerRows[l] == network->layerWeights[l]->rows);
+			assert(plan->layerColumns[l] == network->layerWeights[l]->columns);
+			assert(plan->layerBlockSizes[l] >= 0);
+			assert(plan->layerThreads[l] >= 1 && plan->layerThreads[l] <= 2);
+		}
+		// one node, so one thread
+		assert(plan->layerThreads[3] == 1);
+		assert(nn_Plan_matches(plan, network, 8, 2));
+		assert(!nn_Plan_matches(plan, network, 16, 2));
+		assert(!nn_Plan_matches(plan, network, 8, 4));
+
+		nn_Matrix *inputs = nn_Matrix_alloc(8, 20);
+		for (int i = 0; i < 8 * 20; i++) {
+			inputs->data[i] = (i % 3) * 0.5;
+		}
+		nn_Matrix *expected = nn_Network_allocInference(network, inputs);
+		assert(nn_Plan_applyToNetwork(plan, network));
+		nn_Matrix *outputs = nn_Network_allocInference(network, inputs);
+		nn_ThreadTeam *team = nn_ThreadTeam_alloc(2);
+		nn_Plan_applyToThreadTeam(plan, team);
+		for (int l = 1; l < 4; l++) {
+			assert(nn_ThreadTeam_numberOfThreadsForLayer(team, network, l) == plan->layerThreads[l]);
+		}
+		nn_Matrix *teamOutputs = nn_ThreadTeam_inference(team, network, inputs);
+		// blocked kernels can round differently in the last bits
+		for (int i = 0; i < 8; i++) {
+			assert(fabs(outputs->data[i] - expected->data[i]) < 1e-12);
+			assert(fabs(teamOutputs->data[i] - expected->data[i]) < 1e-12);
+		}
+		nn_Matrix_free(teamOutputs);
+		nn_ThreadTeam_free(team);
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(expected);
+		nn_Matrix_free(inputs);
+		nn_Plan_free(plan);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Plan_writeToFile and nn_Plan_allocFromFile, scenario: only loaded for the same shapes
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Plan *plan = nn_Plan_allocByTuning(network, 4, 2);
+		plan->layerBlockSizes[1] = 8;
+		plan->layerThreads[2] = 1;
+		assert(nn_Plan_writeToFile(plan, "tmp.plan") == 0);
+
+		nn_Plan *loaded = nn_Plan_allocFromFile("tmp.plan", network, 4, 2);
+		assert(loaded != NULL);
+		assert(strcmp(loaded->cpuModel, plan->cpuModel) == 0);
+		for (int l = 1; l < 3; l++) {
+			assert(loaded->layerRows[l] == plan->layerRows[l]);
+			assert(loaded->layerColumns[l] == plan->layerColumns[l]);
+			assert(loaded->layerBlockSizes[l] == plan->layerBlockSizes[l]);
+			assert(loaded->layerThreads[l] == plan->layerThreads[l]);
+		}
+		nn_Plan_free(loaded);
+
+		assert(nn_Plan_allocFromFile("tmp.plan", network, 5, 2) == NULL);
+		nn_Network *otherNetwork = nn_Network_alloc("2, 4, 1");
+		assert(nn_Plan_allocFromFile("tmp.plan", otherNetwork, 4, 2) == NULL);
+		nn_Network_free(otherNetwork);
+		remove("tmp.plan");
+		assert(nn_Plan_allocFromFile("tmp.plan", network, 4, 2) == NULL);
+
+		nn_Plan_free(plan);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Plan_applyToNetwork, scenario: plan for a different number of layers
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Plan *plan = nn_Plan_allocByTuning(network, 4, 1);
+		nn_Network *deeperNetwork = nn_Network_alloc("2, 3, 3, 1");
+		assert(!nn_Plan_applyToNetwork(plan, deeperNetwork));
+		assert(deeperNetwork->layerBlockSizes == NULL);
+		nn_Network_free(deeperNetwork);
+		nn_Plan_free(plan);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Plan_allocForNetwork, scenario: tunes and saves the first time, then loads
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		remove("tmp.plan");
+		nn_Plan *plan = nn_Plan_allocForNetwork(network, 4, 1, "tmp.plan");
+		FILE *file = fopen("tmp.plan", "r");
+		assert(file != NULL);
+		fclose(file);
+		// change the file, to check that it's loaded rather than tuned again
+		plan->layerBlockSizes[2] = 32;
+		nn_Plan_writeToFile(plan, "tmp.plan");
+		nn_Plan *loaded = nn_Plan_allocForNetwork(network, 4, 1, "tmp.plan");
+		assert(loaded->layerBlockSizes[2] == 32);
+		nn_Plan_free(loaded);
+		nn_Plan_free(plan);
+		nn_Network_free(network);
+		remove("tmp.plan");
+	}
+
+	// Test nn_Plan_allocByTuning and nn_Plan_allocForNetwork, scenario: threads below 1 are taken as 1
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Plan *plan = nn_Plan_allocByTuning(network, 4, 0);
+		assert(plan->numberOfThreads == 1);
+		for (int l = 1; l < 3; l++) {
+			assert(plan->layerThreads[l] == 1);
+		}
+		nn_Plan_free(plan);
+
+		remove("tmp.plan");
+		plan = nn_Plan_allocForNetwork(network, 4, -2, "tmp.plan");
+		assert(plan->numberOfThreads == 1);
+		assert(plan->layerThreads[1] == 1);
+		nn_Plan *loaded = nn_Plan_allocForNetwork(network, 4, 0, "tmp.plan");
+		assert(loaded != NULL);
+		nn_Plan_free(loaded);
+		nn_Plan_free(plan);
+		nn_Network_free(network);
+		remove("tmp.plan");
+	}
+
+	return 0;
+}
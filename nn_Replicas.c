@@ -0,0 +1,190 @@
+#ifdef __linux__
+#define _GNU_SOURCE	// sched_getcpu, sched_setaffinity, CPU_ALLOC, CPU_SET_S
+#endif
+
+#include <stdlib.h>	// malloc, free, strtol
+#include <stdio.h>	// fopen, fgets, sprintf
+#include <sched.h>	// sched_getcpu, sched_setaffinity, CPU_ALLOC, CPU_FREE
+#include <pthread.h>	// pthread_create, pthread_join
+
+#include "nn_Replicas.h"
+
+// NUMA aware inference. On hosts with more than one NUMA node (e.g. dual socket servers) a thread reading
+// weights from another node's memory has to go across the interconnect, so each node gets its own copy of
+// the weights. Each copy is made by a thread pinned to that node, and Linux places memory on the node of the
+// thread that first writes to it, so the copy ends up in that node's memory.
+// Inference threads should be pinned to a node (see nn_Replicas_pinCurrentThreadToNode), and then
+// nn_Replicas_inference uses the copy on that node.
+// On other platforms, or on hosts with a single node, there's just one copy.
+
+#define NN_REPLICAS_CPULIST_LENGTH	4096
+
+typedef struct {
+	nn_Replicas *replicas;
+	nn_Network *network;
+	int node;
+} nn_ReplicasCopyJob;
+
+// 'private' functions
+void nn_Replicas__findNodes(nn_Replicas *this);
+int nn_Replicas__parseCPUList(char *cpuList, int *cpus);
+void *nn_Replicas__copyOnNode(void *copyJob);
+
+// Copies `network` into the memory of each NUMA node, `network` itself isn't used after this returns.
+nn_Replicas *nn_Replicas_alloc(nn_Network *network) {
+	nn_Replicas *this = malloc(sizeof(nn_Replicas));
+	nn_Replicas__findNodes(this);
+
+	this->nodeNetworks = malloc(sizeof(nn_Network *) * this->numberOfNodes);
+	pthread_t *threads = malloc(sizeof(pthread_t) * this->numberOfNodes);
+	nn_ReplicasCopyJob *jobs = malloc(sizeof(nn_ReplicasCopyJob) * this->numberOfNodes);
+	for (int node = 0; node < this->numberOfNodes; node++) {
+		jobs[node].replicas = this;
+		jobs[node].network = network;
+		jobs[node].node = node;
+		pthread_create(&threads[node], NULL, nn_Replicas__copyOnNode, &jobs[node]);
+	}
+	for (int node = 0; node < this->numberOfNodes; node++) {
+		pthread_join(threads[node], NULL);
+	}
+	free(jobs);
+	free(threads);
+	return this;
+}
+
+nn_Replicas *nn_Replicas_allocFromFile(char *filename) {
+	nn_Network *network = nn_Network_allocFromFile(filename);
+	if (network == NULL) {
+		return NULL;
+	}
+	nn_Replicas *this = nn_Replicas_alloc(network);
+	nn_Network_free(network);
+	return this;
+}
+
+void nn_Replicas_free(nn_Replicas *this) {
+	for (int node = 0; node < this->numberOfNodes; node++) {
+		nn_Network_free(this->nodeNetworks[node]);
+		free(this->nodeCPUs[node]);
+	}
+	free(this->nodeNetworks);
+	free(this->nodeCPUs);
+	free(this->numberOfCPUsAtNode);
+	free(this);
+}
+
+int nn_Replicas_nodeOfCurrentCPU(nn_Replicas *this) {
+#ifdef __linux__
+	int cpu = sched_getcpu();
+	for (int node = 0; node < this->numberOfNodes; node++) {
+		for (int i = 0; i < this->numberOfCPUsAtNode[node]; i++) {
+			if (this->nodeCPUs[node][i] == cpu) {
+				return node;
+			}
+		}
+	}
+#endif
+	return 0;
+}
+
+nn_Network *nn_Replicas_networkForCurrentCPU(nn_Replicas *this) {
+	return this->nodeNetworks[nn_Replicas_nodeOfCurrentCPU(this)];
+}
+
+// Returns a new matrix with the outputs, which the caller needs to free. Safe to call from many threads at once.
+nn_Matrix *nn_Replicas_inference(nn_Replicas *this, nn_Matrix *inputs) {
+	return nn_Network_allocInference(nn_Replicas_networkForCurrentCPU(this), inputs);
+}
+
+// Returns 0 on success, or -1 if the thread couldn't be pinned (e.g. not supported on this platform, or
+// `node` isn't one of the nodes).
+int nn_Replicas_pinCurrentThreadToNode(nn_Replicas *this, int node) {
+#ifdef __linux__
+	if (node < 0 || node >= this->numberOfNodes || this->numberOfCPUsAtNode[node] == 0) {
+		return -1;
+	}
+	// big hosts can have CPU numbers past CPU_SETSIZE, so the set is sized for the highest one
+	int highestCPU = 0;
+	for (int i = 0; i < this->numberOfCPUsAtNode[node]; i++) {
+		if (this->nodeCPUs[node][i] > highestCPU) {
+			highestCPU = this->nodeCPUs[node][i];
+		}
+	}
+	cpu_set_t *cpus = CPU_ALLOC(highestCPU + 1);
+	if (cpus == NULL) {
+		return -1;
+	}
+	size_t cpusSize = CPU_ALLOC_SIZE(highestCPU + 1);
+	CPU_ZERO_S(cpusSize, cpus);
+	for (int i = 0; i < this->numberOfCPUsAtNode[node]; i++) {
+		CPU_SET_S(this->nodeCPUs[node][i], cpusSize, cpus);
+	}
+	int result = sched_setaffinity(0, cpusSize, cpus);
+	CPU_FREE(cpus);
+	return result;
+#else
+	return -1;
+#endif
+}
+
+// Reads the CPUs of each node from sysfs. Nodes without CPUs are left out, since no inference threads run there.
+void nn_Replicas__findNodes(nn_Replicas *this) {
+	this->numberOfNodes = 0;
+	this->numberOfCPUsAtNode = malloc(sizeof(int) * NN_REPLICAS_MAXIMUM_NODES);
+	this->nodeCPUs = malloc(sizeof(int *) * NN_REPLICAS_MAXIMUM_NODES);
+	char filename[64];
+	char cpuList[NN_REPLICAS_CPULIST_LENGTH];
+	for (int systemNode = 0; systemNode < NN_REPLICAS_MAXIMUM_NODES; systemNode++) {
+		sprintf(filename, "/sys/devices/system/node/node%d/cpulist", systemNode);
+		FILE *file = fopen(filename, "r");
+		if (file == NULL) {
+			continue;
+		}
+		if (fgets(cpuList, NN_REPLICAS_CPULIST_LENGTH, file) != NULL) {
+			int numberOfCPUs = nn_Replicas__parseCPUList(cpuList, NULL);
+			if (numberOfCPUs > 0) {
+				this->nodeCPUs[this->numberOfNodes] = malloc(sizeof(int) * numberOfCPUs);
+				nn_Replicas__parseCPUList(cpuList, this->nodeCPUs[this->numberOfNodes]);
+				this->numberOfCPUsAtNode[this->numberOfNodes] = numberOfCPUs;
+				this->numberOfNodes++;
+			}
+		}
+		fclose(file);
+	}
+	// not Linux, or no NUMA information, so just one node where any CPU can run
+	if (this->numberOfNodes == 0) {
+		this->nodeCPUs[0] = NULL;
+		this->numberOfCPUsAtNode[0] = 0;
+		this->numberOfNodes = 1;
+	}
+}
+
+// Parses a list like "0-3,8,10-11" and returns the number of CPUs in it. If `cpus` isn't NULL, it's filled with them.
+int nn_Replicas__parseCPUList(char *cpuList, int *cpus) {
+	int numberOfCPUs = 0;
+	char *position = cpuList;
+	while (*position >= '0' && *position <= '9') {
+		int first = strtol(position, &position, 10);
+		int last = first;
+		if (*position == '-') {
+			last = strtol(position + 1, &position, 10);
+		}
+		for (int cpu = first; cpu <= last; cpu++) {
+			if (cpus != NULL) {
+				cpus[numberOfCPUs] = cpu;
+			}
+			numberOfCPUs++;
+		}
+		if (*position == ',') {
+			position++;
+		}
+	}
+	return numberOfCPUs;
+}
+
+void *nn_Replicas__copyOnNode(void *copyJob) {
+	nn_ReplicasCopyJob *job = copyJob;
+	nn_Replicas_pinCurrentThreadToNode(job->replicas, job->node);
+	job->replicas->nodeNetworks[job->node] = nn_Network_allocCopy(job->network);
+	return NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef __NN_REPLICAS_H__
+#define __NN_REPLICAS_H__
+
+
+#include "nn_Network.h"
+
+#define NN_REPLICAS_MAXIMUM_NODES	64
+
+// Read only copies of a network for inference, one in the memory of each NUMA node.
+typedef struct {
+	int numberOfNodes;
+	nn_Network **nodeNetworks;
+	int *numberOfCPUsAtNode;
+	int **nodeCPUs;	// [node][index] CPU numbers at each node
+} nn_Replicas;
+
+nn_Replicas *nn_Replicas_alloc(nn_Network *network);
+nn_Replicas *nn_Replicas_allocFromFile(char *filename);
+void nn_Replicas_free(nn_Replicas *this);
+
+int nn_Replicas_nodeOfCurrentCPU(nn_Replicas *this);
+nn_Network *nn_Replicas_networkForCurrentCPU(nn_Replicas *this);
+nn_Matrix *nn_Replicas_inference(nn_Replicas *this, nn_Matrix *inputs);
+int nn_Replicas_pinCurrentThreadToNode(nn_Replicas *this, int node);
+
+
+#endif
@@ -0,0 +1,59 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "nn_Replicas.h"
+
+int main() {
+	// Test nn_Replicas_alloc, scenario: one copy per node, with the same weights
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -3.0, 3.0);
+		nn_Replicas *replicas = nn_Replicas_alloc(network);
+		assert(replicas->numberOfNodes >= 1);
+		for (int node = 0; node < replicas->numberOfNodes; node++) {
+			nn_Network *nodeNetwork = replicas->nodeNetworks[node];
+			assert(nodeNetwork != network);
+			assert(nodeNetwork->numberOfLayers == 3);
+			for (int l = 1; l < network->numberOfLayers; l++) {
+				for (int w = 0; w < network->layerWeights[l]->rows * network->layerWeights[l]->columns; w++) {
+					assert(nodeNetwork->layerWeights[l]->data[w] == network->layerWeights[l]->data[w]);
+				}
+			}
+		}
+		nn_Replicas_free(replicas);
+		nn_Network_free(network);
+	}
+
+	// Test nn_Replicas_inference, scenario: pinned to each node in turn (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Replicas *replicas = nn_Replicas_alloc(network);
+		nn_Network_free(network);
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(1, 2, 1.0, 0.0);
+		for (int node = 0; node < replicas->numberOfNodes; node++) {
+			if (nn_Replicas_pinCurrentThreadToNode(replicas, node) == 0) {
+				assert(nn_Replicas_nodeOfCurrentCPU(replicas) == node);
+				assert(nn_Replicas_networkForCurrentCPU(replicas) == replicas->nodeNetworks[node]);
+			}
+			nn_Matrix *outputs = nn_Replicas_inference(replicas, inputs);
+			assert(nn_Matrix_get(outputs, 0, 0) > 0.681 && nn_Matrix_get(outputs, 0, 0) < 0.682);
+			nn_Matrix_free(outputs);
+		}
+		// nodes that don't exist
+		assert(nn_Replicas_pinCurrentThreadToNode(replicas, -1) == -1);
+		assert(nn_Replicas_pinCurrentThreadToNode(replicas, replicas->numberOfNodes) == -1);
+		nn_Matrix_free(inputs);
+		nn_Replicas_free(replicas);
+	}
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>	// malloc, free
+#include <math.h>	// fabs
+
+#include "nn_SparseMatrix.h"
+
+nn_SparseMatrix *nn_SparseMatrix_alloc(int rows, int columns, int numberOfValues) {
+	nn_SparseMatrix *this = malloc(sizeof(nn_SparseMatrix));
+	this->rows = rows;
+	this->columns = columns;
+	this->numberOfValues = numberOfValues;
+	this->rowStarts = malloc(sizeof(int) * (rows + 1));
+	this->columnIndices = malloc(sizeof(int) * numberOfValues);
+	this->values = malloc(sizeof(double) * numberOfValues);
+	return this;
+}
+
+// Only keeps the values from `matrix` where the magnitude is greater than `threshold`.
+nn_SparseMatrix *nn_SparseMatrix_allocFromMatrixWithThreshold(nn_Matrix *matrix, double threshold) {
+	int numberOfValues = 0;
+	int totalSize = matrix->rows * matrix->columns;
+	for (int i = 0; i < totalSize; i++) {
+		if (fabs(matrix->data[i]) > threshold) {
+			numberOfValues++;
+		}
+	}
+
+	nn_SparseMatrix *this = nn_SparseMatrix_alloc(matrix->rows, matrix->columns, numberOfValues);
+	int value = 0;
+	for (int row = 0; row < matrix->rows; row++) {
+		this->rowStarts[row] = value;
+		for (int column = 0; column < matrix->columns; column++) {
+			double valueInMatrix = nn_Matrix_get(matrix, row, column);
+			if (fabs(valueInMatrix) > threshold) {
+				this->columnIndices[value] = column;
+				this->values[value] = valueInMatrix;
+				value++;
+			}
+		}
+	}
+	this->rowStarts[matrix->rows] = value;
+	return this;
+}
+
+// Makes a dense copy, with zeros where there are no values.
+nn_Matrix *nn_SparseMatrix_allocMatrix(nn_SparseMatrix *this) {
+	nn_Matrix *matrix = nn_Matrix_alloc(this->rows, this->columns);
+	nn_Matrix_fillWithZeros(matrix);
+	for (int row = 0; row < this->rows; row++) {
+		for (int value = this->rowStarts[row]; value < this->rowStarts[row + 1]; value++) {
+			nn_Matrix_set(matrix, row, this->columnIndices[value], this->values[value]);
+		}
+	}
+	return matrix;
+}
+
+void nn_SparseMatrix_free(nn_SparseMatrix *this) {
+	free(this->rowStarts);
+	free(this->columnIndices);
+	free(this->values);
+	free(this);
+}
+
+double nn_SparseMatrix_get(nn_SparseMatrix *this, int row, int column) {
+	for (int value = this->rowStarts[row]; value < this->rowStarts[row + 1]; value++) {
+		if (this->columnIndices[value] == column) {
+			return this->values[value];
+		}
+	}
+	return 0.0;
+}
+
+// Fills `output` with the dot product of the (dense) `inputs` and this matrix, then applies `functionToApply`
+// (if it isn't NULL) to each element. Only the stored values are multiplied, so the work done is proportional
+// to the number of values rather than the size of the matrix.
+void nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *inputs,
+		double (*functionToApply)(double)) {
+	nn_Matrix_fillWithZeros(output);
+	for (int inputRow = 0; inputRow < inputs->rows; inputRow++) {
+		double *outputRow = output->data + inputRow * output->columns;
+		// each input in this row is multiplied by the values in the corresponding row of this matrix
+		for (int inputColumn = 0; inputColumn < inputs->columns; inputColumn++) {
+			double input = nn_Matrix_get(inputs, inputRow, inputColumn);
+			if (input == 0.0) {
+				continue;
+			}
+			for (int value = this->rowStarts[inputColumn]; value < this->rowStarts[inputColumn + 1]; value++) {
+				outputRow[this->columnIndices[value]] += input * this->values[value];
+			}
+		}
+		if (functionToApply != NULL) {
+			for (int outputColumn = 0; outputColumn < output->columns; outputColumn++) {
+				outputRow[outputColumn] = functionToApply(outputRow[outputColumn]);
+			}
+		}
+	}
+}
+
+// Fills `output` with the dot product of this matrix and the (dense) `matrix`, then applies `functionToApply`
+// (if it isn't NULL) to each element. Each row of the output is the sum of the rows of `matrix` picked out by the
+// column indexes in the same row of this matrix, times their values.
+void nn_SparseMatrix_fillMatrixWithGatheredRowsThenFunctionApplied(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *matrix,
+		double (*functionToApply)(double)) {
+	nn_Matrix_fillWithZeros(output);
+	for (int row = 0; row < this->rows; row++) {
+		double *outputRow = output->data + row * output->columns;
+		for (int value = this->rowStarts[row]; value < this->rowStarts[row + 1]; value++) {
+			double *matrixRow = matrix->data + this->columnIndices[value] * matrix->columns;
+			for (int column = 0; column < output->columns; column++) {
+				outputRow[column] += this->values[value] * matrixRow[column];
+			}
+		}
+		if (functionToApply != NULL) {
+			for (int column = 0; column < output->columns; column++) {
+				outputRow[column] = functionToApply(outputRow[column]);
+			}
+		}
+	}
+}
+
+// Adds the dot product of this matrix transposed and `rows`, times `scale`, to `output`. Only the rows of `output`
+// picked out by this matrix's column indexes are changed.
+void nn_SparseMatrix_scatterAddToMatrix(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *rows, double scale) {
+	for (int row = 0; row < this->rows; row++) {
+		double *rowsRow = rows->data + row * rows->columns;
+		for (int value = this->rowStarts[row]; value < this->rowStarts[row + 1]; value++) {
+			double *outputRow = output->data + this->columnIndices[value] * output->columns;
+			double scaledValue = this->values[value] * scale;
+			for (int column = 0; column < output->columns; column++) {
+				outputRow[column] += scaledValue * rowsRow[column];
+			}
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef __NN_SPARSEMATRIX_H__
+#define __NN_SPARSEMATRIX_H__
+
+
+#include "nn_Matrix.h"
+
+// Compressed sparse row (CSR) matrix, only the non zero values are stored.
+// The values for row `r` are at indexes `rowStarts[r]` up to (but not including) `rowStarts[r + 1]`
+// of `values`, and the column each of those values is in is at the same index of `columnIndices`.
+typedef struct {
+	int rows;
+	int columns;
+	int numberOfValues;
+	int *rowStarts;
+	int *columnIndices;
+	double *values;
+} nn_SparseMatrix;
+
+nn_SparseMatrix *nn_SparseMatrix_alloc(int rows, int columns, int numberOfValues);
+nn_SparseMatrix *nn_SparseMatrix_allocFromMatrixWithThreshold(nn_Matrix *matrix, double threshold);
+nn_Matrix *nn_SparseMatrix_allocMatrix(nn_SparseMatrix *this);
+void nn_SparseMatrix_free(nn_SparseMatrix *this);
+double nn_SparseMatrix_get(nn_SparseMatrix *this, int row, int column);
+void nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *inputs,
+		double (*functionToApply)(double));
+void nn_SparseMatrix_fillMatrixWithGatheredRowsThenFunctionApplied(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *matrix,
+		double (*functionToApply)(double));
+void nn_SparseMatrix_scatterAddToMatrix(nn_SparseMatrix *this, nn_Matrix *output, nn_Matrix *rows, double scale);
+
+
+#endif
@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include "nn_SparseMatrix.h"
+
+// Test function used in test for nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied
+double addOne(double input) {
+	return input + 1.0;
+}
+
+int main() {
+	// Test nn_SparseMatrix_allocFromMatrixWithThreshold, scenario: basic
+	{
+		nn_Matrix *matrix = nn_Matrix_allocWithValues(3, 3,
+			0.0, 2.0, 0.1,
+			0.0, 0.0, 0.0,
+			-3.0, 0.0, 4.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(matrix, 0.5);
+		assert(sparse->rows == 3);
+		assert(sparse->columns == 3);
+		assert(sparse->numberOfValues == 3);
+		assert(sparse->rowStarts[0] == 0);
+		assert(sparse->rowStarts[1] == 1);
+		assert(sparse->rowStarts[2] == 1);
+		assert(sparse->rowStarts[3] == 3);
+		assert(sparse->columnIndices[0] == 1);
+		assert(sparse->values[0] == 2.0);
+		assert(sparse->columnIndices[1] == 0);
+		assert(sparse->values[1] == -3.0);
+		assert(sparse->columnIndices[2] == 2);
+		assert(sparse->values[2] == 4.0);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(matrix);
+	}
+
+	// Test nn_SparseMatrix_get, scenario: basic
+	{
+		nn_Matrix *matrix = nn_Matrix_allocWithValues(2, 2,
+			0.0, 2.0,
+			3.0, 0.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(matrix, 0.0);
+		assert(nn_SparseMatrix_get(sparse, 0, 0) == 0.0);
+		assert(nn_SparseMatrix_get(sparse, 0, 1) == 2.0);
+		assert(nn_SparseMatrix_get(sparse, 1, 0) == 3.0);
+		assert(nn_SparseMatrix_get(sparse, 1, 1) == 0.0);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(matrix);
+	}
+
+	// Test nn_SparseMatrix_allocMatrix, scenario: basic
+	{
+		nn_Matrix *matrix = nn_Matrix_allocWithValues(2, 2,
+			0.0, 2.0,
+			3.0, 0.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(matrix, 0.0);
+		nn_Matrix *dense = nn_SparseMatrix_allocMatrix(sparse);
+		assert(nn_Matrix_get(dense, 0, 0) == 0.0);
+		assert(nn_Matrix_get(dense, 0, 1) == 2.0);
+		assert(nn_Matrix_get(dense, 1, 0) == 3.0);
+		assert(nn_Matrix_get(dense, 1, 1) == 0.0);
+		nn_Matrix_free(dense);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(matrix);
+	}
+
+	// Test nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied, scenario: same as dense dot product
+	{
+		// Same pre-computed values as Test nn_Matrix_allocWithDotProductThenFunctionApplied
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+			1.0, 1.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		);
+		nn_Matrix *weights = nn_Matrix_allocWithValues(2, 3,
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(weights, 0.0);
+		nn_Matrix *result = nn_Matrix_alloc(4, 3);
+		nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied(sparse, result, inputs, addOne);
+		// First row
+		assert(nn_Matrix_get(result, 0, 0) == -2.0);
+		assert(nn_Matrix_get(result, 0, 1) == 2.0);
+		assert(nn_Matrix_get(result, 0, 2) == 1.0);
+		// Second row
+		assert(nn_Matrix_get(result, 1, 0) == 0.0);
+		assert(nn_Matrix_get(result, 1, 1) == 2.0);
+		assert(nn_Matrix_get(result, 1, 2) == -1.0);
+		// Third row
+		assert(nn_Matrix_get(result, 2, 0) == -1.0);
+		assert(nn_Matrix_get(result, 2, 1) == 1.0);
+		assert(nn_Matrix_get(result, 2, 2) == 3.0);
+		// Last row
+		assert(nn_Matrix_get(result, 3, 0) == -2.0);
+		assert(nn_Matrix_get(result, 3, 1) == 2.0);
+		assert(nn_Matrix_get(result, 3, 2) == 1.0);
+		nn_Matrix_free(result);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(weights);
+		nn_Matrix_free(inputs);
+	}
+
+	// Test nn_SparseMatrix_fillMatrixWithGatheredRowsThenFunctionApplied, scenario: one-hot rows
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(2, 3,
+			0.0, 1.0, 0.0,
+			2.0, 0.0, 1.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(inputs, 0.0);
+		nn_Matrix *weights = nn_Matrix_allocWithValues(3, 2,
+			1.0, 2.0,
+			3.0, 4.0,
+			5.0, 6.0
+		);
+		nn_Matrix *result = nn_Matrix_alloc(2, 2);
+		nn_SparseMatrix_fillMatrixWithGatheredRowsThenFunctionApplied(sparse, result, weights, addOne);
+		assert(nn_Matrix_get(result, 0, 0) == 4.0);
+		assert(nn_Matrix_get(result, 0, 1) == 5.0);
+		assert(nn_Matrix_get(result, 1, 0) == 8.0);
+		assert(nn_Matrix_get(result, 1, 1) == 11.0);
+		nn_Matrix_free(result);
+		nn_Matrix_free(weights);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(inputs);
+	}
+
+	// Test nn_SparseMatrix_scatterAddToMatrix, scenario: only referenced rows change
+	{
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(2, 3,
+			0.0, 1.0, 0.0,
+			2.0, 1.0, 0.0
+		);
+		nn_SparseMatrix *sparse = nn_SparseMatrix_allocFromMatrixWithThreshold(inputs, 0.0);
+		nn_Matrix *rows = nn_Matrix_allocWithValues(2, 2,
+			1.0, 2.0,
+			3.0, 4.0
+		);
+		nn_Matrix *output = nn_Matrix_allocWithValues(3, 2,
+			0.0, 0.0,
+			10.0, 10.0,
+			7.0, 7.0
+		);
+		nn_SparseMatrix_scatterAddToMatrix(sparse, output, rows, 0.5);
+		assert(nn_Matrix_get(output, 0, 0) == 3.0);
+		assert(nn_Matrix_get(output, 0, 1) == 4.0);
+		assert(nn_Matrix_get(output, 1, 0) == 12.0);
+		assert(nn_Matrix_get(output, 1, 1) == 13.0);
+		assert(nn_Matrix_get(output, 2, 0) == 7.0);
+		assert(nn_Matrix_get(output, 2, 1) == 7.0);
+		nn_Matrix_free(output);
+		nn_Matrix_free(rows);
+		nn_SparseMatrix_free(sparse);
+		nn_Matrix_free(inputs);
+	}
+
+	return 0;
+}
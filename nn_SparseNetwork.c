@@ -0,0 +1,238 @@
+#include <stdlib.h>	// malloc, free, qsort
+#include <string.h>	// strlen
+#include <math.h>	// fabs
+#include <stdio.h>	// printf, fopen
+
+#include "nn_SparseNetwork.h"
+
+// 'private' functions
+int nn_SparseNetwork__compareMagnitudes(const void *a, const void *b);
+
+// Magnitude pruning, in each layer the `fractionToPrune` weights closest to zero are removed (set to zero).
+// Layers that end up sparse enough are stored as sparse matrices, the rest stay dense. `fractionToPrune` is clamped
+// to between 0 and 1.
+nn_SparseNetwork *nn_SparseNetwork_allocByPruning(nn_Network *network, double fractionToPrune) {
+	// written so that NaN ends up as 0 too
+	if (!(fractionToPrune > 0.0)) {
+		fractionToPrune = 0.0;
+	}
+	else if (fractionToPrune > 1.0) {
+		fractionToPrune = 1.0;
+	}
+	nn_SparseNetwork *this = malloc(sizeof(nn_SparseNetwork));
+	this->numberOfLayers = network->numberOfLayers;
+	this->numberOfInputs = network->numberOfInputs;
+	this->layerWeights = calloc(network->numberOfLayers, sizeof(nn_Matrix *));
+	this->layerSparseWeights = calloc(network->numberOfLayers, sizeof(nn_SparseMatrix *));
+
+	// starts at 1 because there are no weights at the input layer
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		nn_Matrix *layerWeights = network->layerWeights[l];
+		int numberOfWeights = layerWeights->rows * layerWeights->columns;
+
+		// Find the magnitude at or below which weights are removed, by sorting all the magnitudes
+		int numberToPrune = (int)(fractionToPrune * numberOfWeights);
+		double threshold = 0.0;
+		if (numberToPrune > 0) {
+			double *magnitudes = malloc(sizeof(double) * numberOfWeights);
+			for (int w = 0; w < numberOfWeights; w++) {
+				magnitudes[w] = fabs(layerWeights->data[w]);
+			}
+			qsort(magnitudes, numberOfWeights, sizeof(double), nn_SparseNetwork__compareMagnitudes);
+			threshold = magnitudes[numberToPrune - 1];
+			free(magnitudes);
+		}
+
+		nn_SparseMatrix *sparseWeights = nn_SparseMatrix_allocFromMatrixWithThreshold(layerWeights, threshold);
+		if (1.0 - (double)sparseWeights->numberOfValues / numberOfWeights >= NN_SPARSE_MINIMUM_SPARSITY) {
+			this->layerSparseWeights[l] = sparseWeights;
+		}
+		else {
+			this->layerWeights[l] = nn_SparseMatrix_allocMatrix(sparseWeights);
+			nn_SparseMatrix_free(sparseWeights);
+		}
+	}
+	return this;
+}
+
+// File format is:
+// - int (numberOfLayers)
+// for each layer, except input layer (i.e. numberOfLayers - 1)
+// - int (rows)
+// - int (columns)
+// - int (numberOfValues, or -1 for a dense layer)
+// for dense layers
+// - array/sequence of doubles (amount of doubles is: rows x columns)
+// for sparse layers
+// - array/sequence of ints (rowStarts, amount of ints is: rows + 1)
+// - array/sequence of ints (columnIndices, amount of ints is: numberOfValues)
+// - array/sequence of doubles (values, amount of doubles is: numberOfValues)
+// TODO: Handle corrupt file
+nn_SparseNetwork *nn_SparseNetwork_allocFromFile(char *filename) {
+	// make sure there's no '.lock' file
+	char *lockFileName = malloc(sizeof(char) * (strlen(filename) + strlen(".lock") + 1));
+	sprintf(lockFileName, "%s.lock", filename);
+	FILE *lock = fopen(lockFileName, "r");
+	if (lock != NULL) {
+		free(lockFileName);
+		fclose(lock);
+		printf("Not reading from '%s' because '%s.lock' exists.\n", filename, filename);
+		return NULL;
+	}
+
+	// create .lock file
+	lock = fopen(lockFileName, "w");
+	fclose(lock);
+
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		printf("Error opening file '%s' to read weights from.\n", filename);
+		remove(lockFileName);
+		free(lockFileName);
+		return NULL;
+	}
+
+	nn_SparseNetwork *this = malloc(sizeof(nn_SparseNetwork));
+	fread(&(this->numberOfLayers), sizeof(int), 1, file);
+	this->layerWeights = calloc(this->numberOfLayers, sizeof(nn_Matrix *));
+	this->layerSparseWeights = calloc(this->numberOfLayers, sizeof(nn_SparseMatrix *));
+
+	int rows, columns, numberOfValues;
+	// starts at layer 1 because there are no weights at the input layer
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		fread(&rows, sizeof(int), 1, file);
+		fread(&columns, sizeof(int), 1, file);
+		fread(&numberOfValues, sizeof(int), 1, file);
+		if (l == 1) {
+			this->numberOfInputs = rows;
+		}
+		if (numberOfValues < 0) {
+			this->layerWeights[l] = nn_Matrix_alloc(rows, columns);
+			fread(this->layerWeights[l]->data, sizeof(double), rows * columns, file);
+		}
+		else {
+			nn_SparseMatrix *sparseWeights = nn_SparseMatrix_alloc(rows, columns, numberOfValues);
+			fread(sparseWeights->rowStarts, sizeof(int), rows + 1, file);
+			fread(sparseWeights->columnIndices, sizeof(int), numberOfValues, file);
+			fread(sparseWeights->values, sizeof(double), numberOfValues, file);
+			this->layerSparseWeights[l] = sparseWeights;
+		}
+	}
+
+	fclose(file);
+
+	remove(lockFileName);
+	free(lockFileName);
+
+	return this;
+}
+
+void nn_SparseNetwork_free(nn_SparseNetwork *this) {
+	// Starts at 1 because there are no weights for the first layer
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		if (this->layerWeights[l] != NULL) {
+			nn_Matrix_free(this->layerWeights[l]);
+		}
+		if (this->layerSparseWeights[l] != NULL) {
+			nn_SparseMatrix_free(this->layerSparseWeights[l]);
+		}
+	}
+	free(this->layerWeights);
+	free(this->layerSparseWeights);
+	free(this);
+}
+
+// Returns a new matrix with the outputs, which the caller needs to free.
+nn_Matrix *nn_SparseNetwork_inference(nn_SparseNetwork *this, nn_Matrix *inputs) {
+	nn_Matrix *previousActivations = inputs;
+	nn_Matrix *activations = NULL;
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		activations = nn_Matrix_alloc(inputs->rows, nn_SparseNetwork_numberOfNodesAtLayerIndex(this, l));
+		if (this->layerSparseWeights[l] != NULL) {
+			nn_SparseMatrix_fillMatrixWithDotProductThenFunctionApplied(this->layerSparseWeights[l], activations,
+					previousActivations, nn_Network_activation);
+		}
+		else {
+			nn_Matrix_fillWithDotProductThenFunctionApplied(activations, previousActivations, this->layerWeights[l],
+					nn_Network_activation);
+		}
+		// only the outputs are kept
+		if (previousActivations != inputs) {
+			nn_Matrix_free(previousActivations);
+		}
+		previousActivations = activations;
+	}
+	return activations;
+}
+
+int nn_SparseNetwork_numberOfNodesAtLayerIndex(nn_SparseNetwork *this, int layerIndex) {
+	if (layerIndex == 0) {
+		return this->numberOfInputs;
+	}
+	else if (this->layerSparseWeights[layerIndex] != NULL) {
+		return this->layerSparseWeights[layerIndex]->columns;
+	}
+	else {
+		return this->layerWeights[layerIndex]->columns;
+	}
+}
+
+// File format is described above nn_SparseNetwork_allocFromFile
+int nn_SparseNetwork_writeToFile(nn_SparseNetwork *this, char *filename) {
+	// make sure there's no '.lock' file
+	char *lockFileName = malloc(sizeof(char) * (strlen(filename) + strlen(".lock") + 1));
+	sprintf(lockFileName, "%s.lock", filename);
+	FILE *lock = fopen(lockFileName, "r");
+	if (lock != NULL) {
+		free(lockFileName);
+		fclose(lock);
+		printf("Not writing to '%s' because '%s.lock' exists.\n", filename, filename);
+		return NN_ERROR_WRITE_LOCK_FILE;
+	}
+
+	// create .lock file
+	lock = fopen(lockFileName, "w");
+	fclose(lock);
+
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL) {
+		printf("Error opening file '%s' to write weights to.\n", filename);
+		remove(lockFileName);
+		free(lockFileName);
+		return NN_ERROR_WRITE_FOPEN_FAIL;
+	}
+
+	fwrite(&(this->numberOfLayers), sizeof(int), 1, file);
+	// below starts at 1 because input layer doesn't have weights
+	for (int l = 1; l < this->numberOfLayers; l++) {
+		if (this->layerSparseWeights[l] != NULL) {
+			nn_SparseMatrix *sparseWeights = this->layerSparseWeights[l];
+			fwrite(&(sparseWeights->rows), sizeof(int), 1, file);
+			fwrite(&(sparseWeights->columns), sizeof(int), 1, file);
+			fwrite(&(sparseWeights->numberOfValues), sizeof(int), 1, file);
+			fwrite(sparseWeights->rowStarts, sizeof(int), sparseWeights->rows + 1, file);
+			fwrite(sparseWeights->columnIndices, sizeof(int), sparseWeights->numberOfValues, file);
+			fwrite(sparseWeights->values, sizeof(double), sparseWeights->numberOfValues, file);
+		}
+		else {
+			nn_Matrix *layerWeights = this->layerWeights[l];
+			int dense = -1;
+			fwrite(&(layerWeights->rows), sizeof(int), 1, file);
+			fwrite(&(layerWeights->columns), sizeof(int), 1, file);
+			fwrite(&dense, sizeof(int), 1, file);
+			fwrite(layerWeights->data, sizeof(double), layerWeights->rows * layerWeights->columns, file);
+		}
+	}
+	fclose(file);
+
+	remove(lockFileName);
+	free(lockFileName);
+
+	return 0;
+}
+
+int nn_SparseNetwork__compareMagnitudes(const void *a, const void *b) {
+	double magnitudeA = *(const double *)a;
+	double magnitudeB = *(const double *)b;
+	return (magnitudeA > magnitudeB) - (magnitudeA < magnitudeB);
+}
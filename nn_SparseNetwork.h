@@ -0,0 +1,30 @@
+#ifndef __NN_SPARSENETWORK_H__
+#define __NN_SPARSENETWORK_H__
+
+
+#include "nn_Network.h"
+#include "nn_SparseMatrix.h"
+
+// Layers with a smaller fraction of zero weights than this are kept dense, because the column indexes
+// stored with each sparse value would cost more than skipping the zeros saves.
+#define NN_SPARSE_MINIMUM_SPARSITY	0.5
+
+// A pruned copy of an nn_Network for inference. Each layer has either dense or sparse weights, the other is NULL.
+typedef struct {
+	int numberOfLayers;
+	int numberOfInputs;
+	nn_Matrix **layerWeights;
+	nn_SparseMatrix **layerSparseWeights;
+} nn_SparseNetwork;
+
+nn_SparseNetwork *nn_SparseNetwork_allocByPruning(nn_Network *network, double fractionToPrune);
+nn_SparseNetwork *nn_SparseNetwork_allocFromFile(char *filename);
+void nn_SparseNetwork_free(nn_SparseNetwork *this);
+
+nn_Matrix *nn_SparseNetwork_inference(nn_SparseNetwork *this, nn_Matrix *inputs);
+int nn_SparseNetwork_numberOfNodesAtLayerIndex(nn_SparseNetwork *this, int layerIndex);
+
+int nn_SparseNetwork_writeToFile(nn_SparseNetwork *this, char *filename);
+
+
+#endif
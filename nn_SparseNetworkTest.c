@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "nn_SparseNetwork.h"
+
+int main() {
+	// Test nn_SparseNetwork_allocByPruning, scenario: sparse and dense layers
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.1, 2.0,
+			-1.0, 1.5, -0.2
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0, 2.0,
+			0.5, -2.0,
+			1.0, -1.0
+		);
+		// prunes 4 of 6 weights in each layer
+		nn_SparseNetwork *sparseNetwork = nn_SparseNetwork_allocByPruning(network, 0.7);
+		assert(sparseNetwork->numberOfLayers == 3);
+		assert(sparseNetwork->numberOfInputs == 2);
+		assert(nn_SparseNetwork_numberOfNodesAtLayerIndex(sparseNetwork, 1) == 3);
+		assert(nn_SparseNetwork_numberOfNodesAtLayerIndex(sparseNetwork, 2) == 2);
+		assert(sparseNetwork->layerWeights[1] == NULL);
+		assert(sparseNetwork->layerSparseWeights[1]->numberOfValues == 2);
+		assert(nn_SparseMatrix_get(sparseNetwork->layerSparseWeights[1], 0, 0) == -2.0);
+		assert(nn_SparseMatrix_get(sparseNetwork->layerSparseWeights[1], 0, 2) == 2.0);
+		assert(sparseNetwork->layerWeights[2] == NULL);
+		assert(sparseNetwork->layerSparseWeights[2]->numberOfValues == 2);
+		nn_SparseNetwork_free(sparseNetwork);
+
+		// nothing pruned, so layers stay dense
+		sparseNetwork = nn_SparseNetwork_allocByPruning(network, 0.0);
+		assert(sparseNetwork->layerSparseWeights[1] == NULL);
+		assert(nn_Matrix_get(sparseNetwork->layerWeights[1], 0, 1) == 0.1);
+		assert(sparseNetwork->layerSparseWeights[2] == NULL);
+		nn_SparseNetwork_free(sparseNetwork);
+
+		// fractions outside 0 to 1 are clamped
+		sparseNetwork = nn_SparseNetwork_allocByPruning(network, -0.5);
+		assert(sparseNetwork->layerSparseWeights[1] == NULL);
+		assert(nn_Matrix_get(sparseNetwork->layerWeights[1], 0, 1) == 0.1);
+		nn_SparseNetwork_free(sparseNetwork);
+		sparseNetwork = nn_SparseNetwork_allocByPruning(network, 1.5);
+		assert(sparseNetwork->layerSparseWeights[1]->numberOfValues == 0);
+		assert(sparseNetwork->layerSparseWeights[2]->numberOfValues == 0);
+		nn_SparseNetwork_free(sparseNetwork);
+		nn_Network_free(network);
+	}
+
+	// Test nn_SparseNetwork_inference, scenario: same as nn_Network_inference after pruning the same weights
+	{
+		nn_Network *network = nn_Network_alloc("20, 30, 10, 4");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -1.0, 1.0);
+		nn_SparseNetwork *sparseNetwork = nn_SparseNetwork_allocByPruning(network, 0.8);
+		// zero the pruned weights in the original network
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			nn_Matrix *layerWeights = network->layerWeights[l];
+			for (int row = 0; row < layerWeights->rows; row++) {
+				for (int column = 0; column < layerWeights->columns; column++) {
+					nn_Matrix_set(layerWeights, row, column, nn_SparseMatrix_get(sparseNetwork->layerSparseWeights[l], row, column));
+				}
+			}
+		}
+		nn_Matrix *inputs = nn_Matrix_alloc(3, 20);
+		for (int i = 0; i < 3 * 20; i++) {
+			inputs->data[i] = (i % 4) / 3.0;
+		}
+		nn_Matrix *outputs = nn_SparseNetwork_inference(sparseNetwork, inputs);
+		nn_Matrix *expectedOutputs = nn_Network_inference(network, inputs);
+		for (int i = 0; i < 3 * 4; i++) {
+			assert(fabs(outputs->data[i] - expectedOutputs->data[i]) < 1e-12);
+		}
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(inputs);
+		nn_SparseNetwork_free(sparseNetwork);
+		nn_Network_free(network);
+	}
+
+	// Test nn_SparseNetwork_writeToFile and nn_SparseNetwork_allocFromFile, scenario: round trip
+	{
+		nn_Network *network = nn_Network_alloc("2, 3, 2");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.1, 2.0,
+			-1.0, 1.5, -0.2
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0, 2.0,
+			0.5, -2.0,
+			1.0, -1.0
+		);
+		nn_SparseNetwork *sparseNetwork = nn_SparseNetwork_allocByPruning(network, 0.5);
+		// layer 1 is sparse after pruning 3 of 6 weights, make layer 2 dense to test both
+		nn_SparseMatrix_free(sparseNetwork->layerSparseWeights[2]);
+		sparseNetwork->layerSparseWeights[2] = NULL;
+		sparseNetwork->layerWeights[2] = nn_Matrix_allocWithValues(3, 2,
+			-1.0, 2.0,
+			0.5, -2.0,
+			1.0, -1.0
+		);
+		int writeResult = nn_SparseNetwork_writeToFile(sparseNetwork, "tmp.nns");
+		assert(writeResult == 0);
+
+		nn_SparseNetwork *readNetwork = nn_SparseNetwork_allocFromFile("tmp.nns");
+		assert(readNetwork->numberOfLayers == 3);
+		assert(readNetwork->numberOfInputs == 2);
+		assert(readNetwork->layerWeights[1] == NULL);
+		assert(readNetwork->layerSparseWeights[1]->numberOfValues == 3);
+		assert(nn_SparseMatrix_get(readNetwork->layerSparseWeights[1], 0, 0) == -2.0);
+		assert(nn_SparseMatrix_get(readNetwork->layerSparseWeights[1], 0, 1) == 0.0);
+		assert(nn_SparseMatrix_get(readNetwork->layerSparseWeights[1], 0, 2) == 2.0);
+		assert(nn_SparseMatrix_get(readNetwork->layerSparseWeights[1], 1, 1) == 1.5);
+		assert(readNetwork->layerSparseWeights[2] == NULL);
+		assert(nn_Matrix_get(readNetwork->layerWeights[2], 1, 0) == 0.5);
+		assert(nn_Matrix_get(readNetwork->layerWeights[2], 2, 1) == -1.0);
+
+		nn_SparseNetwork_free(readNetwork);
+		nn_SparseNetwork_free(sparseNetwork);
+		nn_Network_free(network);
+		remove("tmp.nns");
+	}
+
+	return 0;
+}
@@ -0,0 +1,238 @@
+#include <stdlib.h>	// malloc, free
+#include <string.h>	// strlen, strcpy
+#include <math.h>	// log, exp, INFINITY
+#include <time.h>	// clock_gettime
+#include <pthread.h>	// pthread_create, pthread_join, pthread_mutex_*
+
+#include "nn_Sweep.h"
+
+// Hyperparameter sweeps, i.e. training many configurations (layout, training increment, seed) to find which
+// works best. Every configuration is trained by a pool of threads against the same training data, which is
+// only read, so there's just one copy of it in memory however many configurations run at once.
+// Each configuration is trained in one piece by a single thread. Some configurations take much longer than
+// others (bigger layouts, or cancelled early), so threads that run out of work steal from the others.
+
+#define NN_SWEEP_DEFAULT_MAXIMUM_STEPS	1000
+
+typedef struct {
+	nn_Sweep *sweep;
+	int thread;
+} nn_SweepWorker;
+
+// 'private' functions
+nn_Sweep *nn_Sweep__alloc(int numberOfConfigurations);
+void nn_Sweep__setConfiguration(nn_SweepConfiguration *configuration, char *layout, double trainingIncrement, unsigned int seed);
+void *nn_Sweep__runWorker(void *worker);
+int nn_Sweep__takeConfiguration(nn_Sweep *this, int thread);
+void nn_Sweep__trainConfiguration(nn_Sweep *this, nn_SweepConfiguration *configuration);
+
+// Every combination of the layouts, training increments and seeds.
+nn_Sweep *nn_Sweep_allocGrid(char **layouts, int numberOfLayouts, double *trainingIncrements, int numberOfTrainingIncrements,
+		unsigned int *seeds, int numberOfSeeds) {
+	nn_Sweep *this = nn_Sweep__alloc(numberOfLayouts * numberOfTrainingIncrements * numberOfSeeds);
+	nn_SweepConfiguration *configuration = this->configurations;
+	for (int l = 0; l < numberOfLayouts; l++) {
+		for (int t = 0; t < numberOfTrainingIncrements; t++) {
+			for (int s = 0; s < numberOfSeeds; s++) {
+				nn_Sweep__setConfiguration(configuration, layouts[l], trainingIncrements[t], seeds[s]);
+				configuration++;
+			}
+		}
+	}
+	return this;
+}
+
+// Random search, each configuration gets one of the layouts, a training increment between the min and max
+// (evenly spread on a log scale, so e.g. 0.01 to 0.1 is as likely as 0.1 to 1.0), and its own seed.
+// The same `seed` always gives the same configurations.
+nn_Sweep *nn_Sweep_allocRandom(char **layouts, int numberOfLayouts, double minTrainingIncrement, double maxTrainingIncrement,
+		int numberOfConfigurations, unsigned int seed) {
+	nn_Sweep *this = nn_Sweep__alloc(numberOfConfigurations);
+	unsigned long long state = nn_Network_randomState(seed);
+	double logMin = log(minTrainingIncrement);
+	double logMax = log(maxTrainingIncrement);
+	for (int c = 0; c < numberOfConfigurations; c++) {
+		int layout = (int)(nn_Network_random(&state) * numberOfLayouts);
+		double trainingIncrement = exp(logMin + nn_Network_random(&state) * (logMax - logMin));
+		unsigned int configurationSeed = (unsigned int)(nn_Network_random(&state) * 4294967296.0);
+		nn_Sweep__setConfiguration(&this->configurations[c], layouts[layout], trainingIncrement, configurationSeed);
+	}
+	return this;
+}
+
+void nn_Sweep_free(nn_Sweep *this) {
+	for (int c = 0; c < this->numberOfConfigurations; c++) {
+		nn_SweepConfiguration *configuration = &this->configurations[c];
+		free(configuration->layout);
+		free(configuration->costs);
+		if (configuration->network != NULL) {
+			nn_Network_free(configuration->network);
+		}
+	}
+	free(this->configurations);
+	free(this);
+}
+
+// Trains every configuration with `numberOfThreads` threads, and returns when they've all finished.
+// The settings in nn_Sweep (maximumSteps, patience etc.) can be changed before calling this. Running again
+// trains every configuration again from the start, replacing the results of the last run.
+void nn_Sweep_run(nn_Sweep *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, int numberOfThreads) {
+	for (int c = 0; c < this->numberOfConfigurations; c++) {
+		nn_SweepConfiguration *configuration = &this->configurations[c];
+		free(configuration->costs);
+		configuration->costs = NULL;
+		if (configuration->network != NULL) {
+			nn_Network_free(configuration->network);
+			configuration->network = NULL;
+		}
+		configuration->numberOfSteps = 0;
+		configuration->cancelled = false;
+		configuration->seconds = 0.0;
+	}
+	this->trainingDataInputs = trainingDataInputs;
+	this->trainingDataOutputs = trainingDataOutputs;
+	this->numberOfThreads = numberOfThreads;
+
+	// share the configurations out between the threads' queues
+	this->queues = malloc(sizeof(nn_SweepQueue) * numberOfThreads);
+	for (int t = 0; t < numberOfThreads; t++) {
+		nn_SweepQueue *queue = &this->queues[t];
+		pthread_mutex_init(&queue->mutex, NULL);
+		queue->configurations = malloc(sizeof(int) * (this->numberOfConfigurations / numberOfThreads + 1));
+		queue->front = 0;
+		queue->back = 0;
+		for (int c = t; c < this->numberOfConfigurations; c += numberOfThreads) {
+			queue->configurations[queue->back++] = c;
+		}
+	}
+
+	pthread_t *threads = malloc(sizeof(pthread_t) * numberOfThreads);
+	nn_SweepWorker *workers = malloc(sizeof(nn_SweepWorker) * numberOfThreads);
+	for (int t = 0; t < numberOfThreads; t++) {
+		workers[t].sweep = this;
+		workers[t].thread = t;
+		pthread_create(&threads[t], NULL, nn_Sweep__runWorker, &workers[t]);
+	}
+	for (int t = 0; t < numberOfThreads; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	free(workers);
+	free(threads);
+
+	for (int t = 0; t < numberOfThreads; t++) {
+		pthread_mutex_destroy(&this->queues[t].mutex);
+		free(this->queues[t].configurations);
+	}
+	free(this->queues);
+	this->queues = NULL;
+	this->trainingDataInputs = NULL;
+	this->trainingDataOutputs = NULL;
+}
+
+// The configuration with the lowest cost after its last step, or NULL if the sweep hasn't run.
+nn_SweepConfiguration *nn_Sweep_bestConfiguration(nn_Sweep *this) {
+	nn_SweepConfiguration *best = NULL;
+	for (int c = 0; c < this->numberOfConfigurations; c++) {
+		nn_SweepConfiguration *configuration = &this->configurations[c];
+		if (configuration->numberOfSteps == 0) {
+			continue;
+		}
+		if (best == NULL || configuration->costs[configuration->numberOfSteps - 1] < best->costs[best->numberOfSteps - 1]) {
+			best = configuration;
+		}
+	}
+	return best;
+}
+
+nn_Sweep *nn_Sweep__alloc(int numberOfConfigurations) {
+	nn_Sweep *this = malloc(sizeof(nn_Sweep));
+	this->numberOfConfigurations = numberOfConfigurations;
+	this->configurations = malloc(sizeof(nn_SweepConfiguration) * numberOfConfigurations);
+	this->maximumSteps = NN_SWEEP_DEFAULT_MAXIMUM_STEPS;
+	this->patience = 0;
+	this->minimumImprovement = 0.0;
+	this->minWeight = -3.0;
+	this->maxWeight = 3.0;
+	this->trainingDataInputs = NULL;
+	this->trainingDataOutputs = NULL;
+	this->numberOfThreads = 0;
+	this->queues = NULL;
+	return this;
+}
+
+void nn_Sweep__setConfiguration(nn_SweepConfiguration *configuration, char *layout, double trainingIncrement, unsigned int seed) {
+	configuration->layout = malloc(sizeof(char) * (strlen(layout) + 1));
+	strcpy(configuration->layout, layout);
+	configuration->trainingIncrement = trainingIncrement;
+	configuration->seed = seed;
+	configuration->network = NULL;
+	configuration->costs = NULL;
+	configuration->numberOfSteps = 0;
+	configuration->cancelled = false;
+	configuration->seconds = 0.0;
+}
+
+void *nn_Sweep__runWorker(void *worker) {
+	nn_SweepWorker *this = worker;
+	int c;
+	while ((c = nn_Sweep__takeConfiguration(this->sweep, this->thread)) >= 0) {
+		nn_Sweep__trainConfiguration(this->sweep, &this->sweep->configurations[c]);
+	}
+	return NULL;
+}
+
+// Returns the next configuration for `thread` to train, or -1 when there are none left in any queue.
+// No configurations are added once the sweep is running, so when every queue is empty the thread can stop.
+int nn_Sweep__takeConfiguration(nn_Sweep *this, int thread) {
+	// the thread's own queue first, from the back
+	nn_SweepQueue *queue = &this->queues[thread];
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->back > queue->front) {
+		int c = queue->configurations[--queue->back];
+		pthread_mutex_unlock(&queue->mutex);
+		return c;
+	}
+	pthread_mutex_unlock(&queue->mutex);
+
+	// then steal from the front of the other threads' queues, starting with the next one along
+	for (int i = 1; i < this->numberOfThreads; i++) {
+		queue = &this->queues[(thread + i) % this->numberOfThreads];
+		pthread_mutex_lock(&queue->mutex);
+		if (queue->back > queue->front) {
+			int c = queue->configurations[queue->front++];
+			pthread_mutex_unlock(&queue->mutex);
+			return c;
+		}
+		pthread_mutex_unlock(&queue->mutex);
+	}
+	return -1;
+}
+
+void nn_Sweep__trainConfiguration(nn_Sweep *this, nn_SweepConfiguration *configuration) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	nn_Network *network = nn_Network_alloc(configuration->layout);
+	nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, this->minWeight, this->maxWeight, configuration->seed);
+	configuration->costs = malloc(sizeof(double) * this->maximumSteps);
+	double bestCost = INFINITY;
+	int stepsWithoutImprovement = 0;
+	for (int step = 0; step < this->maximumSteps; step++) {
+		double cost = nn_Network_train(network, this->trainingDataInputs, this->trainingDataOutputs,
+				configuration->trainingIncrement);
+		configuration->costs[step] = cost;
+		configuration->numberOfSteps = step + 1;
+		if (cost < bestCost - this->minimumImprovement) {
+			bestCost = cost;
+			stepsWithoutImprovement = 0;
+		}
+		else if (this->patience > 0 && ++stepsWithoutImprovement >= this->patience) {
+			configuration->cancelled = true;
+			break;
+		}
+	}
+	configuration->network = network;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	configuration->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
@@ -0,0 +1,60 @@
+#ifndef __NN_SWEEP_H__
+#define __NN_SWEEP_H__
+
+
+#include <stdbool.h>	// bool, true, false
+#include <pthread.h>	// pthread_mutex_t
+
+#include "nn_Network.h"
+
+// One set of hyperparameters, and the results of training with them.
+typedef struct {
+	char *layout;	// as passed to nn_Network_alloc
+	double trainingIncrement;
+	unsigned int seed;	// for nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed
+
+	nn_Network *network;	// the trained network, NULL until the sweep has run
+	double *costs;	// average cost after each step, the loss curve
+	int numberOfSteps;	// steps actually taken, fewer than maximumSteps if it was cancelled
+	bool cancelled;	// stopped because the cost stopped improving
+	double seconds;	// wall time taken to train
+} nn_SweepConfiguration;
+
+// Configurations waiting to be trained by one of the threads. Threads take from the back of their own
+// queue, and when it's empty steal from the front of another thread's queue.
+typedef struct {
+	pthread_mutex_t mutex;
+	int *configurations;	// indexes into the sweep's configurations
+	int front;
+	int back;
+} nn_SweepQueue;
+
+typedef struct {
+	int numberOfConfigurations;
+	nn_SweepConfiguration *configurations;
+	int maximumSteps;
+	// Configurations whose cost hasn't improved by at least `minimumImprovement` for `patience` steps
+	// are cancelled, a patience of 0 never cancels.
+	int patience;
+	double minimumImprovement;
+	double minWeight;	// range of the random starting weights
+	double maxWeight;
+
+	// only used while running
+	nn_Matrix *trainingDataInputs;
+	nn_Matrix *trainingDataOutputs;
+	int numberOfThreads;
+	nn_SweepQueue *queues;
+} nn_Sweep;
+
+nn_Sweep *nn_Sweep_allocGrid(char **layouts, int numberOfLayouts, double *trainingIncrements, int numberOfTrainingIncrements,
+		unsigned int *seeds, int numberOfSeeds);
+nn_Sweep *nn_Sweep_allocRandom(char **layouts, int numberOfLayouts, double minTrainingIncrement, double maxTrainingIncrement,
+		int numberOfConfigurations, unsigned int seed);
+void nn_Sweep_free(nn_Sweep *this);
+
+void nn_Sweep_run(nn_Sweep *this, nn_Matrix *trainingDataInputs, nn_Matrix *trainingDataOutputs, int numberOfThreads);
+nn_SweepConfiguration *nn_Sweep_bestConfiguration(nn_Sweep *this);
+
+
+#endif
@@ -0,0 +1,121 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nn_Sweep.h"
+
+int main() {
+	nn_Matrix *inputs = nn_Matrix_allocWithValues(4, 2,
+		0.0, 0.0,
+		0.0, 1.0,
+		1.0, 0.0,
+		1.0, 1.0
+	);
+	nn_Matrix *outputs = nn_Matrix_allocWithValues(4, 1,
+		1.0,
+		0.0,
+		0.0,
+		1.0
+	);
+
+	// Test nn_Sweep_allocGrid, scenario: every combination
+	{
+		char *layouts[2] = { "2, 3, 1", "2, 4, 1" };
+		double trainingIncrements[3] = { 0.5, 1.0, 2.0 };
+		unsigned int seeds[2] = { 1, 2 };
+		nn_Sweep *sweep = nn_Sweep_allocGrid(layouts, 2, trainingIncrements, 3, seeds, 2);
+		assert(sweep->numberOfConfigurations == 12);
+		assert(strcmp(sweep->configurations[0].layout, "2, 3, 1") == 0);
+		assert(sweep->configurations[0].trainingIncrement == 0.5);
+		assert(sweep->configurations[0].seed == 1);
+		assert(sweep->configurations[1].seed == 2);
+		assert(sweep->configurations[2].trainingIncrement == 1.0);
+		assert(strcmp(sweep->configurations[11].layout, "2, 4, 1") == 0);
+		assert(sweep->configurations[11].trainingIncrement == 2.0);
+		assert(sweep->configurations[11].seed == 2);
+		assert(sweep->configurations[11].network == NULL);
+		assert(nn_Sweep_bestConfiguration(sweep) == NULL);
+		nn_Sweep_free(sweep);
+	}
+
+	// Test nn_Sweep_allocRandom, scenario: values in range, and the same seed gives the same configurations
+	{
+		char *layouts[2] = { "2, 3, 1", "2, 4, 1" };
+		nn_Sweep *sweep = nn_Sweep_allocRandom(layouts, 2, 0.1, 10.0, 20, 7);
+		nn_Sweep *same = nn_Sweep_allocRandom(layouts, 2, 0.1, 10.0, 20, 7);
+		assert(sweep->numberOfConfigurations == 20);
+		for (int c = 0; c < 20; c++) {
+			assert(strcmp(sweep->configurations[c].layout, layouts[0]) == 0 ||
+					strcmp(sweep->configurations[c].layout, layouts[1]) == 0);
+			assert(sweep->configurations[c].trainingIncrement >= 0.1);
+			assert(sweep->configurations[c].trainingIncrement <= 10.0);
+			assert(strcmp(sweep->configurations[c].layout, same->configurations[c].layout) == 0);
+			assert(sweep->configurations[c].trainingIncrement == same->configurations[c].trainingIncrement);
+			assert(sweep->configurations[c].seed == same->configurations[c].seed);
+		}
+		nn_Sweep_free(same);
+		nn_Sweep_free(sweep);
+	}
+
+	// Test nn_Sweep_run, scenario: same results as training each configuration on its own
+	{
+		char *layouts[2] = { "2, 3, 1", "2, 5, 2, 1" };
+		double trainingIncrements[2] = { 1.0, 4.0 };
+		unsigned int seeds[3] = { 1, 2, 3 };
+		nn_Sweep *sweep = nn_Sweep_allocGrid(layouts, 2, trainingIncrements, 2, seeds, 3);
+		sweep->maximumSteps = 50;
+		nn_Sweep_run(sweep, inputs, outputs, 3);
+		for (int c = 0; c < sweep->numberOfConfigurations; c++) {
+			nn_SweepConfiguration *configuration = &sweep->configurations[c];
+			assert(configuration->numberOfSteps == 50);
+			assert(!configuration->cancelled);
+			assert(configuration->seconds >= 0.0);
+			assert(configuration->network != NULL);
+
+			nn_Network *network = nn_Network_alloc(configuration->layout);
+			nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -3.0, 3.0, configuration->seed);
+			for (int step = 0; step < 50; step++) {
+				double cost = nn_Network_train(network, inputs, outputs, configuration->trainingIncrement);
+				assert(cost == configuration->costs[step]);
+			}
+			nn_Network_free(network);
+		}
+		nn_SweepConfiguration *best = nn_Sweep_bestConfiguration(sweep);
+		for (int c = 0; c < sweep->numberOfConfigurations; c++) {
+			assert(best->costs[49] <= sweep->configurations[c].costs[49]);
+		}
+		// the inputs and outputs are only read
+		assert(nn_Matrix_get(inputs, 1, 1) == 1.0);
+		assert(nn_Matrix_get(outputs, 3, 0) == 1.0);
+		nn_Sweep_free(sweep);
+	}
+
+	// Test nn_Sweep_run, scenario: cancelled when the cost stops improving
+	{
+		char *layouts[1] = { "2, 3, 1" };
+		// an increment of 0 never changes the weights, so the cost never improves after the first step
+		double trainingIncrements[2] = { 0.0, 1.0 };
+		unsigned int seeds[1] = { 1 };
+		nn_Sweep *sweep = nn_Sweep_allocGrid(layouts, 1, trainingIncrements, 2, seeds, 1);
+		sweep->maximumSteps = 100;
+		sweep->patience = 5;
+		nn_Sweep_run(sweep, inputs, outputs, 2);
+		assert(sweep->configurations[0].cancelled);
+		assert(sweep->configurations[0].numberOfSteps == 6);
+		assert(!sweep->configurations[1].cancelled);
+		assert(sweep->configurations[1].numberOfSteps == 100);
+		assert(nn_Sweep_bestConfiguration(sweep) == &sweep->configurations[1]);
+
+		// running again starts every configuration again
+		sweep->patience = 0;
+		nn_Sweep_run(sweep, inputs, outputs, 2);
+		assert(!sweep->configurations[0].cancelled);
+		assert(sweep->configurations[0].numberOfSteps == 100);
+		assert(sweep->configurations[0].costs[99] == sweep->configurations[0].costs[0]);
+		nn_Sweep_free(sweep);
+	}
+
+	nn_Matrix_free(inputs);
+	nn_Matrix_free(outputs);
+	return 0;
+}
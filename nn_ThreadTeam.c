@@ -0,0 +1,216 @@
+#ifdef __linux__
+#define _GNU_SOURCE	// pthread_setaffinity_np, sched_getaffinity, CPU_SET
+#endif
+
+#include <stdlib.h>	// malloc, free
+#include <sched.h>	// sched_yield, sched_getaffinity
+#include <pthread.h>	// pthread_create, pthread_join, pthread_mutex_lock, pthread_cond_wait, pthread_cond_broadcast
+
+#include "nn_ThreadTeam.h"
+
+// A team of pinned threads that split the nodes of each wide layer between them, to cut the latency of a
+// single inference (e.g. one row of inputs) rather than to increase throughput. Threads wait for each other
+// with a spinning barrier between layers, because each layer needs all of the previous layer's activations.
+// Between inferences the barrier stops spinning after a while and the members go to sleep until the next one.
+
+#define NN_THREADTEAM_SPINS_BEFORE_YIELD	4096
+#define NN_THREADTEAM_YIELDS_BEFORE_SLEEP	64
+
+// 'private' functions
+void *nn_ThreadTeam__runMember(void *member);
+void nn_ThreadTeam__wait(nn_ThreadTeam *this);
+void nn_ThreadTeam__inferenceForMember(nn_ThreadTeam *this, int memberIndex);
+void nn_ThreadTeam__pinToCPU(pthread_t thread, int index);
+
+nn_ThreadTeam *nn_ThreadTeam_alloc(int numberOfThreads) {
+	nn_ThreadTeam *this = malloc(sizeof(nn_ThreadTeam));
+	this->numberOfThreads = numberOfThreads;
+	atomic_init(&this->barrierCount, 0);
+	atomic_init(&this->barrierGeneration, 0);
+	pthread_mutex_init(&this->sleepMutex, NULL);
+	pthread_cond_init(&this->wakeUp, NULL);
+	atomic_init(&this->numberOfSleepers, 0);
+	atomic_init(&this->stop, 0);
+	this->layerThreads = NULL;
+	this->network = NULL;
+	this->layerActivations = NULL;
+	this->numberOfLayerActivations = 0;
+
+	// Member 0 is whichever thread calls nn_ThreadTeam_inference, so only the others get their own thread
+	this->members = malloc(sizeof(nn_ThreadTeamMember) * numberOfThreads);
+	for (int i = 0; i < numberOfThreads; i++) {
+		this->members[i].team = this;
+		this->members[i].index = i;
+		if (i > 0) {
+			pthread_create(&this->members[i].thread, NULL, nn_ThreadTeam__runMember, &this->members[i]);
+			nn_ThreadTeam__pinToCPU(this->members[i].thread, i);
+		}
+	}
+	return this;
+}
+
+void nn_ThreadTeam_free(nn_ThreadTeam *this) {
+	atomic_store(&this->stop, 1);
+	nn_ThreadTeam__wait(this);
+	for (int i = 1; i < this->numberOfThreads; i++) {
+		pthread_join(this->members[i].thread, NULL);
+	}
+	// index 0 is the inputs, which belong to the caller
+	for (int l = 1; l < this->numberOfLayerActivations; l++) {
+		if (this->layerActivations[l] != NULL) {
+			nn_Matrix_free(this->layerActivations[l]);
+		}
+	}
+	free(this->layerActivations);
+	free(this->layerThreads);
+	free(this->members);
+	pthread_cond_destroy(&this->wakeUp);
+	pthread_mutex_destroy(&this->sleepMutex);
+	free(this);
+}
+
+// Returns a new matrix with the outputs, which the caller needs to free. Doesn't change the network, so
+// different teams can run inference on the same network at the same time.
+nn_Matrix *nn_ThreadTeam_inference(nn_ThreadTeam *this, nn_Network *network, nn_Matrix *inputs) {
+	// Keep the intermediate activations between calls, they only need to change when the shapes do
+	if (this->numberOfLayerActivations != network->numberOfLayers) {
+		for (int l = 1; l < this->numberOfLayerActivations; l++) {
+			if (this->layerActivations[l] != NULL) {
+				nn_Matrix_free(this->layerActivations[l]);
+			}
+		}
+		free(this->layerActivations);
+		this->layerActivations = calloc(network->numberOfLayers, sizeof(nn_Matrix *));
+		this->numberOfLayerActivations = network->numberOfLayers;
+	}
+	for (int l = 1; l < network->numberOfLayers - 1; l++) {
+		nn_Matrix *activations = this->layerActivations[l];
+		if (activations == NULL || activations->rows != inputs->rows || activations->columns != network->layerWeights[l]->columns) {
+			if (activations != NULL) {
+				nn_Matrix_free(activations);
+			}
+			this->layerActivations[l] = nn_Matrix_alloc(inputs->rows, network->layerWeights[l]->columns);
+		}
+	}
+	// The outputs are given to the caller, so they're not kept
+	nn_Matrix *outputs = nn_Matrix_alloc(inputs->rows, network->layerWeights[network->numberOfLayers - 1]->columns);
+	this->layerActivations[0] = inputs;
+	this->layerActivations[network->numberOfLayers - 1] = outputs;
+	this->network = network;
+
+	// Only wake the team up if at least one layer is wide enough to share
+	int shareAnyLayer = 0;
+	for (int l = 1; l < network->numberOfLayers; l++) {
+		if (nn_ThreadTeam_numberOfThreadsForLayer(this, network, l) > 1) {
+			shareAnyLayer = 1;
+		}
+	}
+	if (shareAnyLayer) {
+		nn_ThreadTeam__wait(this);	// start
+		nn_ThreadTeam__inferenceForMember(this, 0);
+	}
+	else {
+		for (int l = 1; l < network->numberOfLayers; l++) {
+			nn_Network_fillActivationsAtLayer(network, l, this->layerActivations[l], this->layerActivations[l - 1]);
+		}
+	}
+
+	this->layerActivations[0] = NULL;
+	this->layerActivations[network->numberOfLayers - 1] = NULL;
+	return outputs;
+}
+
+int nn_ThreadTeam_numberOfThreadsForLayer(nn_ThreadTeam *this, nn_Network *network, int layer) {
+	nn_Matrix *layerWeights = network->layerWeights[layer];
+	int numberOfThreads = this->layerThreads != NULL ? this->layerThreads[layer] :
+			layerWeights->rows * layerWeights->columns / NN_THREADTEAM_MINIMUM_WEIGHTS_PER_THREAD;
+	if (numberOfThreads > this->numberOfThreads) {
+		numberOfThreads = this->numberOfThreads;
+	}
+	if (numberOfThreads > layerWeights->columns) {
+		numberOfThreads = layerWeights->columns;
+	}
+	return numberOfThreads < 1 ? 1 : numberOfThreads;
+}
+
+void *nn_ThreadTeam__runMember(void *member) {
+	nn_ThreadTeamMember *this = member;
+	while (1) {
+		nn_ThreadTeam__wait(this->team);	// start
+		if (atomic_load(&this->team->stop)) {
+			return NULL;
+		}
+		nn_ThreadTeam__inferenceForMember(this->team, this->index);
+	}
+}
+
+// Each member calculates its share of the nodes in each layer, then waits for the others before moving on.
+void nn_ThreadTeam__inferenceForMember(nn_ThreadTeam *this, int memberIndex) {
+	nn_Network *network = this->network;
+	// the caller can free the network as soon as the last barrier is passed, so don't read it after that
+	int numberOfLayers = network->numberOfLayers;
+	for (int l = 1; l < numberOfLayers; l++) {
+		int numberOfThreads = nn_ThreadTeam_numberOfThreadsForLayer(this, network, l);
+		if (memberIndex < numberOfThreads) {
+			int numberOfNodes = network->layerWeights[l]->columns;
+			nn_Network_fillActivationsAtLayerForNodes(network, l, this->layerActivations[l], this->layerActivations[l - 1],
+					numberOfNodes * memberIndex / numberOfThreads, numberOfNodes * (memberIndex + 1) / numberOfThreads);
+		}
+		nn_ThreadTeam__wait(this);
+	}
+}
+
+// Spinning barrier, every member has to call this before any of them carry on.
+void nn_ThreadTeam__wait(nn_ThreadTeam *this) {
+	int generation = atomic_load_explicit(&this->barrierGeneration, memory_order_acquire);
+	if (atomic_fetch_add_explicit(&this->barrierCount, 1, memory_order_acq_rel) == this->numberOfThreads - 1) {
+		// last one here, let everyone go
+		atomic_store_explicit(&this->barrierCount, 0, memory_order_relaxed);
+		atomic_store(&this->barrierGeneration, generation + 1);
+		// Sleepers count themselves before checking the generation, so either they see the new one, or they're
+		// counted here and wait on the mutex until they're asleep to be woken up
+		if (atomic_load(&this->numberOfSleepers) > 0) {
+			pthread_mutex_lock(&this->sleepMutex);
+			pthread_cond_broadcast(&this->wakeUp);
+			pthread_mutex_unlock(&this->sleepMutex);
+		}
+		return;
+	}
+	int spins = 0;
+	while (atomic_load_explicit(&this->barrierGeneration, memory_order_acquire) == generation) {
+		// don't hog the CPU if the team is idle between inferences
+		if (++spins > NN_THREADTEAM_SPINS_BEFORE_YIELD + NN_THREADTEAM_YIELDS_BEFORE_SLEEP) {
+			pthread_mutex_lock(&this->sleepMutex);
+			atomic_fetch_add(&this->numberOfSleepers, 1);
+			while (atomic_load(&this->barrierGeneration) == generation) {
+				pthread_cond_wait(&this->wakeUp, &this->sleepMutex);
+			}
+			atomic_fetch_sub(&this->numberOfSleepers, 1);
+			pthread_mutex_unlock(&this->sleepMutex);
+			return;
+		}
+		if (spins > NN_THREADTEAM_SPINS_BEFORE_YIELD) {
+			sched_yield();
+		}
+	}
+}
+
+// Pins to the `index`th CPU this process is allowed to run on (e.g. under taskset or in a container), wrapping around.
+void nn_ThreadTeam__pinToCPU(pthread_t thread, int index) {
+#ifdef __linux__
+	cpu_set_t allowedCPUs;
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &allowedCPUs) != 0 || CPU_COUNT(&allowedCPUs) == 0) {
+		return;
+	}
+	int remaining = index % CPU_COUNT(&allowedCPUs);
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, &allowedCPUs) && remaining-- == 0) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(cpu, &cpus);
+			pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpus);
+			return;
+		}
+	}
+#endif
+}
@@ -0,0 +1,46 @@
+#ifndef __NN_THREADTEAM_H__
+#define __NN_THREADTEAM_H__
+
+
+#include <pthread.h>	// pthread_t, pthread_mutex_t, pthread_cond_t
+#include <stdatomic.h>	// atomic_int
+
+#include "nn_Network.h"
+
+// Layers with fewer weights than this per thread are calculated by a single thread, because
+// waiting at the barrier would cost more than the time saved.
+#define NN_THREADTEAM_MINIMUM_WEIGHTS_PER_THREAD	8192
+
+typedef struct nn_ThreadTeam nn_ThreadTeam;
+
+typedef struct {
+	nn_ThreadTeam *team;
+	int index;
+	pthread_t thread;
+} nn_ThreadTeamMember;
+
+struct nn_ThreadTeam {
+	int numberOfThreads;	// includes the thread calling nn_ThreadTeam_inference
+	nn_ThreadTeamMember *members;
+	atomic_int barrierCount;
+	atomic_int barrierGeneration;
+	// Members that have waited at the barrier for a while sleep on this, so an idle team doesn't use any CPU
+	pthread_mutex_t sleepMutex;
+	pthread_cond_t wakeUp;
+	atomic_int numberOfSleepers;
+	atomic_int stop;
+	int *layerThreads;	// number of threads for each layer, NULL to decide from the number of weights (see nn_Plan)
+	// The inference currently being run, set before the team is woken up
+	nn_Network *network;
+	nn_Matrix **layerActivations;
+	int numberOfLayerActivations;
+};
+
+nn_ThreadTeam *nn_ThreadTeam_alloc(int numberOfThreads);
+void nn_ThreadTeam_free(nn_ThreadTeam *this);
+
+nn_Matrix *nn_ThreadTeam_inference(nn_ThreadTeam *this, nn_Network *network, nn_Matrix *inputs);
+int nn_ThreadTeam_numberOfThreadsForLayer(nn_ThreadTeam *this, nn_Network *network, int layer);
+
+
+#endif
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <sched.h>	// sched_yield
+
+#include "nn_ThreadTeam.h"
+
+int main() {
+	// Test nn_ThreadTeam_numberOfThreadsForLayer, scenario: narrow and wide layers
+	{
+		nn_ThreadTeam *team = nn_ThreadTeam_alloc(4);
+		nn_Network *network = nn_Network_alloc("2, 3, 1024, 64");
+		assert(nn_ThreadTeam_numberOfThreadsForLayer(team, network, 1) == 1);
+		assert(nn_ThreadTeam_numberOfThreadsForLayer(team, network, 2) == 1);
+		assert(nn_ThreadTeam_numberOfThreadsForLayer(team, network, 3) == 4);
+		nn_Network_free(network);
+		nn_ThreadTeam_free(team);
+	}
+
+	// Test nn_ThreadTeam_inference, scenario: narrow network (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn_ThreadTeam *team = nn_ThreadTeam_alloc(4);
+		nn_Network *network = nn_Network_alloc("2, 3, 1");
+		nn_Matrix_fillWithValues(network->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn_Matrix *inputs = nn_Matrix_allocWithValues(1, 2, 1.0, 0.0);
+		nn_Matrix *outputs = nn_ThreadTeam_inference(team, network, inputs);
+		assert(outputs->rows == 1);
+		assert(outputs->columns == 1);
+		assert(nn_Matrix_get(outputs, 0, 0) > 0.681 && nn_Matrix_get(outputs, 0, 0) < 0.682);
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(inputs);
+		nn_Network_free(network);
+		nn_ThreadTeam_free(team);
+	}
+
+	// Test nn_ThreadTeam_inference, scenario: wide network, repeated single rows match nn_Network_inference
+	{
+		nn_ThreadTeam *team = nn_ThreadTeam_alloc(3);
+		nn_Network *network = nn_Network_alloc("256, 512, 256, 5");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -0.1, 0.1);
+		for (int i = 0; i < 10; i++) {
+			nn_Matrix *inputs = nn_Matrix_alloc(1, 256);
+			for (int j = 0; j < 256; j++) {
+				inputs->data[j] = ((i + j) % 7) / 7.0;
+			}
+			nn_Matrix *outputs = nn_ThreadTeam_inference(team, network, inputs);
+			nn_Matrix *expectedOutputs = nn_Network_inference(network, inputs);
+			for (int j = 0; j < 5; j++) {
+				assert(nn_Matrix_get(outputs, 0, j) == nn_Matrix_get(expectedOutputs, 0, j));
+			}
+			nn_Matrix_free(outputs);
+			nn_Matrix_free(inputs);
+		}
+		nn_Network_free(network);
+		nn_ThreadTeam_free(team);
+	}
+
+	// Test nn_ThreadTeam_inference, scenario: idle members go to sleep, and are woken up for the next inference
+	{
+		nn_ThreadTeam *team = nn_ThreadTeam_alloc(3);
+		nn_Network *network = nn_Network_alloc("256, 512, 5");
+		nn_Network_randomiseWeightsBetweenMinAndMax(network, -0.1, 0.1);
+		while (atomic_load(&team->numberOfSleepers) < 2) {
+			sched_yield();
+		}
+		nn_Matrix *inputs = nn_Matrix_alloc(1, 256);
+		nn_Matrix *outputs = nn_ThreadTeam_inference(team, network, inputs);
+		nn_Matrix *expectedOutputs = nn_Network_inference(network, inputs);
+		for (int j = 0; j < 5; j++) {
+			assert(nn_Matrix_get(outputs, 0, j) == nn_Matrix_get(expectedOutputs, 0, j));
+		}
+		nn_Matrix_free(outputs);
+		nn_Matrix_free(inputs);
+		nn_Network_free(network);
+		nn_ThreadTeam_free(team);
+	}
+
+	return 0;
+}
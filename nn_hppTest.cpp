@@ -0,0 +1,152 @@
+#include <assert.h>
+#include <stdio.h>
+#include <math.h>
+#include <stdexcept>
+#include <utility>
+
+#include "nn.hpp"
+
+int main() {
+	// Test nn::Matrix, scenario: values and moving
+	{
+		nn::Matrix matrix(2, 3, {
+			1.0, 2.0, 3.0,
+			4.0, 5.0, 6.0
+		});
+		assert(matrix.rows() == 2);
+		assert(matrix.columns() == 3);
+		assert(matrix(1, 0) == 4.0);
+		assert(nn_Matrix_get(matrix.get(), 0, 2) == 3.0);
+		matrix(1, 2) = 7.0;
+		assert(matrix.data()[5] == 7.0);
+
+		nn::Matrix moved(std::move(matrix));
+		assert(matrix.get() == nullptr);
+		assert(moved(1, 2) == 7.0);
+		nn::Matrix other(1, 1);
+		other = std::move(moved);
+		assert(other.rows() == 2);
+	}
+
+	// Test nn::Matrix, scenario: wrong number of values
+	{
+		bool threw = false;
+		try {
+			nn::Matrix matrix(2, 2, { 1.0, 2.0, 3.0 });
+		}
+		catch (std::invalid_argument &) {
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	// Test nn::Network inference, scenario: basic (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn::Matrix inputs(4, 2, {
+			0.0, 0.0,
+			0.0, 1.0,
+			1.0, 0.0,
+			1.0, 1.0
+		});
+		nn::Network network("2, 3, 1");
+		nn_Matrix_fillWithValues(network.get()->layerWeights[1],
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		);
+		nn_Matrix_fillWithValues(network.get()->layerWeights[2],
+			-1.0,
+			0.0,
+			1.0
+		);
+		nn::Matrix outputs = network.inference(inputs);
+		assert(outputs.rows() == 4);
+		assert(outputs.columns() == 1);
+		assert(outputs(0, 0) > 0.499 && outputs(0, 0) < 0.501);
+		assert(outputs(1, 0) > 0.462 && outputs(1, 0) < 0.463);
+		assert(outputs(2, 0) > 0.681 && outputs(2, 0) < 0.682);
+		assert(outputs(3, 0) > 0.611 && outputs(3, 0) < 0.612);
+	}
+
+	// Test nn::Network fromFile, scenario: file doesn't exist
+	{
+		bool threw = false;
+		try {
+			nn::Network network = nn::Network::fromFile("doesnt-exist.nn");
+		}
+		catch (std::runtime_error &) {
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	// Test nn::FixedNetwork, scenario: basic (see 2-3-1_example_spreadsheet.ods)
+	{
+		nn::FixedNetwork<2, 3, 1> network;
+		static_assert(nn::FixedNetwork<2, 3, 1>::numberOfInputs == 2, "");
+		static_assert(nn::FixedNetwork<2, 3, 1>::numberOfOutputs == 1, "");
+		assert(network.layout() == "2, 3, 1");
+		double layer1Weights[] = {
+			-2.0, 0.0, 2.0,
+			-1.0, 1.0, -2.0
+		};
+		double layer2Weights[] = {
+			-1.0,
+			0.0,
+			1.0
+		};
+		std::copy(layer1Weights, layer1Weights + 6, network.weightsAtLayer(1));
+		std::copy(layer2Weights, layer2Weights + 3, network.weightsAtLayer(2));
+		assert(network.inference({ 0.0, 0.0 })[0] > 0.499 && network.inference({ 0.0, 0.0 })[0] < 0.501);
+		assert(network.inference({ 0.0, 1.0 })[0] > 0.462 && network.inference({ 0.0, 1.0 })[0] < 0.463);
+		assert(network.inference({ 1.0, 0.0 })[0] > 0.681 && network.inference({ 1.0, 0.0 })[0] < 0.682);
+		assert(network.inference({ 1.0, 1.0 })[0] > 0.611 && network.inference({ 1.0, 1.0 })[0] < 0.612);
+	}
+
+	// Test nn::FixedNetwork, scenario: same results as nn::Network, and same weights after a file round trip
+	{
+		nn::Network network("8, 16, 16, 4");
+		network.randomiseWeightsBetweenMinAndMax(-1.0, 1.0, 42);
+		assert(network.writeToFile("tmp.nn") == 0);
+		auto fixedNetwork = nn::FixedNetwork<8, 16, 16, 4>::fromFile("tmp.nn");
+		remove("tmp.nn");
+
+		nn::Matrix inputs(3, 8);
+		for (int i = 0; i < 3 * 8; i++) {
+			inputs.data()[i] = i / 24.0 - 0.5;
+		}
+		nn::Matrix expected = network.inference(inputs);
+		for (int row = 0; row < 3; row++) {
+			double outputs[4];
+			fixedNetwork.inference(&inputs.data()[row * 8], outputs);
+			for (int column = 0; column < 4; column++) {
+				assert(fabs(outputs[column] - expected(row, column)) < 1e-12);
+			}
+		}
+
+		assert(fixedNetwork.writeToFile("tmp.nn") == 0);
+		nn::Network fromFile = nn::Network::fromFile("tmp.nn");
+		remove("tmp.nn");
+		for (int l = 1; l < 4; l++) {
+			nn_Matrix *weights = network.get()->layerWeights[l];
+			for (int i = 0; i < weights->rows * weights->columns; i++) {
+				assert(fromFile.get()->layerWeights[l]->data[i] == weights->data[i]);
+			}
+		}
+	}
+
+	// Test nn::FixedNetwork copyWeightsFromNetwork, scenario: different layout
+	{
+		nn::Network network("2, 4, 1");
+		nn::FixedNetwork<2, 3, 1> fixedNetwork;
+		bool threw = false;
+		try {
+			fixedNetwork.copyWeightsFromNetwork(network);
+		}
+		catch (std::invalid_argument &) {
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	return 0;
+}
@@ -0,0 +1,262 @@
+#include <stdlib.h>	// malloc, realloc, free, atoi
+#include <string.h>	// strcmp
+#include <stdio.h>	// printf, fprintf, fread
+#include <stdbool.h>	// bool, true, false
+#include <stdatomic.h>	// atomic_size_t
+#include <time.h>	// clock_gettime
+#include <fcntl.h>	// open
+#include <unistd.h>	// close, ftruncate, sysconf
+#include <sys/mman.h>	// mmap, munmap, madvise
+#include <sys/stat.h>	// fstat
+#include <pthread.h>	// pthread_create, pthread_join
+
+#include "nn_Network.h"
+#include "nn_Plan.h"
+
+// Batch inference over binary files, for offline scoring.
+//
+// Usage: nn_infer [options] <network file> <inputs file, or - for stdin> <outputs file>
+//   --float          records are floats rather than doubles (both inputs and outputs)
+//   --threads <n>    number of threads, defaults to the number of CPUs
+//   --batch <n>      rows in each batch, defaults to 256
+//   --plan <file>    load (or tune and save) an nn_Plan for the batch size, see nn_Plan.h
+//
+// The inputs file is a sequence of records, each with one value for every input of the network, in the
+// byte order of this machine. The outputs file is written in the same way, with one value for every output.
+// The inputs file is mapped into memory rather than read, and the outputs file is created at its full size and
+// mapped, so each thread converts its batches straight from one to the other.
+
+#define NN_INFER_DEFAULT_BATCH_SIZE	256
+
+typedef struct {
+	nn_Network *network;
+	bool isFloat;
+	size_t numberOfRows;
+	int batchSize;
+	atomic_size_t nextBatch;
+	char *inputs;
+	char *outputs;
+} nn_Infer;
+
+// 'private' functions
+void *nn_Infer__runWorker(void *infer);
+char *nn_Infer__readAll(FILE *file, size_t *size);
+void nn_Infer__printUsage();
+
+int main(int argc, char *argv[]) {
+	nn_Infer infer;
+	infer.isFloat = false;
+	infer.batchSize = NN_INFER_DEFAULT_BATCH_SIZE;
+	int numberOfThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	char *planFilename = NULL;
+	char *filenames[3];
+	int numberOfFilenames = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--float") == 0) {
+			infer.isFloat = true;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			numberOfThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+			infer.batchSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--plan") == 0 && i + 1 < argc) {
+			planFilename = argv[++i];
+		}
+		else if (numberOfFilenames < 3 && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+			filenames[numberOfFilenames++] = argv[i];
+		}
+		else {
+			nn_Infer__printUsage();
+			return 1;
+		}
+	}
+	if (numberOfFilenames != 3 || numberOfThreads < 1 || infer.batchSize < 1) {
+		nn_Infer__printUsage();
+		return 1;
+	}
+
+	infer.network = nn_Network_allocFromFile(filenames[0]);
+	if (infer.network == NULL) {
+		return 1;
+	}
+	if (planFilename != NULL) {
+		// each thread does its own batches, so the plan is for one thread
+		nn_Plan *plan = nn_Plan_allocForNetwork(infer.network, infer.batchSize, 1, planFilename);
+		if (!nn_Plan_applyToNetwork(plan, infer.network)) {
+			fprintf(stderr, "Plan '%s' is for a different network.\n", planFilename);
+		}
+		nn_Plan_free(plan);
+	}
+	size_t valueSize = infer.isFloat ? sizeof(float) : sizeof(double);
+	size_t inputRecordSize = valueSize * infer.network->numberOfInputs;
+	size_t outputRecordSize = valueSize * nn_Network_numberOfNodesAtLayerIndex(infer.network, infer.network->numberOfLayers - 1);
+
+	// inputs
+	size_t inputsSize;
+	bool inputsMapped = strcmp(filenames[1], "-") != 0;
+	if (inputsMapped) {
+		int inputsFile = open(filenames[1], O_RDONLY);
+		struct stat inputsStat;
+		if (inputsFile < 0 || fstat(inputsFile, &inputsStat) != 0) {
+			fprintf(stderr, "Error opening inputs file '%s'.\n", filenames[1]);
+			if (inputsFile >= 0) {
+				close(inputsFile);
+			}
+			return 1;
+		}
+		inputsSize = (size_t)inputsStat.st_size;
+		infer.inputs = inputsSize > 0 ? mmap(NULL, inputsSize, PROT_READ, MAP_PRIVATE, inputsFile, 0) : NULL;
+		close(inputsFile);
+		if (infer.inputs == MAP_FAILED) {
+			fprintf(stderr, "Error mapping inputs file '%s'.\n", filenames[1]);
+			return 1;
+		}
+		if (inputsSize > 0) {
+			madvise(infer.inputs, inputsSize, MADV_SEQUENTIAL);
+		}
+	}
+	else {
+		infer.inputs = nn_Infer__readAll(stdin, &inputsSize);
+	}
+	if (inputsSize % inputRecordSize != 0) {
+		fprintf(stderr, "Inputs aren't a whole number of records of %d %s.\n", infer.network->numberOfInputs,
+				infer.isFloat ? "floats" : "doubles");
+		return 1;
+	}
+	infer.numberOfRows = inputsSize / inputRecordSize;
+
+	// outputs, at their full size
+	size_t outputsSize = outputRecordSize * infer.numberOfRows;
+	int outputsFile = open(filenames[2], O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (outputsFile < 0 || ftruncate(outputsFile, (off_t)outputsSize) != 0) {
+		fprintf(stderr, "Error creating outputs file '%s'.\n", filenames[2]);
+		if (outputsFile >= 0) {
+			close(outputsFile);
+		}
+		return 1;
+	}
+	infer.outputs = outputsSize > 0 ? mmap(NULL, outputsSize, PROT_READ | PROT_WRITE, MAP_SHARED, outputsFile, 0) : NULL;
+	close(outputsFile);
+	if (infer.outputs == MAP_FAILED) {
+		fprintf(stderr, "Error mapping outputs file '%s'.\n", filenames[2]);
+		return 1;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	atomic_init(&infer.nextBatch, 0);
+	pthread_t *threads = malloc(sizeof(pthread_t) * numberOfThreads);
+	for (int t = 1; t < numberOfThreads; t++) {
+		pthread_create(&threads[t], NULL, nn_Infer__runWorker, &infer);
+	}
+	// this thread does batches too
+	nn_Infer__runWorker(&infer);
+	for (int t = 1; t < numberOfThreads; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	free(threads);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	if (outputsSize > 0) {
+		munmap(infer.outputs, outputsSize);
+	}
+	if (inputsMapped) {
+		if (inputsSize > 0) {
+			munmap(infer.inputs, inputsSize);
+		}
+	}
+	else {
+		free(infer.inputs);
+	}
+	nn_Network_free(infer.network);
+
+	printf("%zu rows in %lf seconds, %.0lf rows/sec\n", infer.numberOfRows, seconds, seconds > 0.0 ? infer.numberOfRows / seconds : 0.0);
+	return 0;
+}
+
+// Takes batches until there are none left. Each thread has its own activations for every layer, which are
+// reused for each batch.
+void *nn_Infer__runWorker(void *infer) {
+	nn_Infer *this = infer;
+	nn_Network *network = this->network;
+	int outputLayer = network->numberOfLayers - 1;
+	nn_Matrix **layerActivations = malloc(sizeof(nn_Matrix *) * network->numberOfLayers);
+	for (int l = 0; l < network->numberOfLayers; l++) {
+		layerActivations[l] = nn_Matrix_alloc(this->batchSize, nn_Network_numberOfNodesAtLayerIndex(network, l));
+	}
+	int numberOfInputs = network->numberOfInputs;
+	int numberOfOutputs = layerActivations[outputLayer]->columns;
+
+	size_t batch;
+	while ((batch = atomic_fetch_add(&this->nextBatch, 1)) * this->batchSize < this->numberOfRows) {
+		size_t firstRow = batch * this->batchSize;
+		// at most batchSize, so it fits in an int like the matrices' rows
+		int numberOfRows = this->numberOfRows - firstRow < (size_t)this->batchSize ? (int)(this->numberOfRows - firstRow) : this->batchSize;
+		// the last batch can be smaller, the matrices are just used with fewer rows
+		for (int l = 0; l < network->numberOfLayers; l++) {
+			layerActivations[l]->rows = numberOfRows;
+		}
+
+		int numberOfInputValues = numberOfRows * numberOfInputs;
+		if (this->isFloat) {
+			float *inputs = (float *)this->inputs + firstRow * numberOfInputs;
+			for (int i = 0; i < numberOfInputValues; i++) {
+				layerActivations[0]->data[i] = inputs[i];
+			}
+		}
+		else {
+			double *inputs = (double *)this->inputs + firstRow * numberOfInputs;
+			for (int i = 0; i < numberOfInputValues; i++) {
+				layerActivations[0]->data[i] = inputs[i];
+			}
+		}
+
+		for (int l = 1; l <= outputLayer; l++) {
+			nn_Network_fillActivationsAtLayer(network, l, layerActivations[l], layerActivations[l - 1]);
+		}
+
+		int numberOfOutputValues = numberOfRows * numberOfOutputs;
+		if (this->isFloat) {
+			float *outputs = (float *)this->outputs + firstRow * numberOfOutputs;
+			for (int i = 0; i < numberOfOutputValues; i++) {
+				outputs[i] = (float)layerActivations[outputLayer]->data[i];
+			}
+		}
+		else {
+			double *outputs = (double *)this->outputs + firstRow * numberOfOutputs;
+			for (int i = 0; i < numberOfOutputValues; i++) {
+				outputs[i] = layerActivations[outputLayer]->data[i];
+			}
+		}
+	}
+
+	for (int l = 0; l < network->numberOfLayers; l++) {
+		nn_Matrix_free(layerActivations[l]);
+	}
+	free(layerActivations);
+	return NULL;
+}
+
+// For inputs that can't be mapped (e.g. a pipe), reads everything into memory. The caller needs to free it.
+char *nn_Infer__readAll(FILE *file, size_t *size) {
+	size_t capacity = 1 << 20;
+	char *data = malloc(capacity);
+	*size = 0;
+	size_t numberRead;
+	while ((numberRead = fread(data + *size, 1, capacity - *size, file)) > 0) {
+		*size += numberRead;
+		if (*size == capacity) {
+			capacity *= 2;
+			data = realloc(data, capacity);
+		}
+	}
+	return data;
+}
+
+void nn_Infer__printUsage() {
+	fprintf(stderr, "Usage: nn_infer [--float] [--threads <n>] [--batch <n>] [--plan <file>] "
+			"<network file> <inputs file, or - for stdin> <outputs file>\n");
+}
@@ -0,0 +1,103 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "nn_Network.h"
+
+// Runs the nn_infer tool (built by the Makefile before this test) on small files, and checks its outputs
+// against nn_Network_allocInference.
+
+#define NUMBER_OF_ROWS	10
+#define NUMBER_OF_INPUTS	3
+#define NUMBER_OF_OUTPUTS	2
+
+// Writes `numberOfValues` of the inputs' values as floats or doubles
+void writeInputs(char *filename, nn_Matrix *inputs, int isFloat, int numberOfValues) {
+	FILE *file = fopen(filename, "wb");
+	for (int i = 0; i < numberOfValues; i++) {
+		if (isFloat) {
+			float value = (float)inputs->data[i];
+			fwrite(&value, sizeof(float), 1, file);
+		}
+		else {
+			fwrite(&inputs->data[i], sizeof(double), 1, file);
+		}
+	}
+	fclose(file);
+}
+
+// Reads the outputs file, which must have exactly one value for each output of each row, and compares it
+void assertOutputs(char *filename, nn_Matrix *expectedOutputs, int isFloat, double tolerance) {
+	FILE *file = fopen(filename, "rb");
+	assert(file != NULL);
+	for (int i = 0; i < NUMBER_OF_ROWS * NUMBER_OF_OUTPUTS; i++) {
+		double value;
+		if (isFloat) {
+			float floatValue;
+			assert(fread(&floatValue, sizeof(float), 1, file) == 1);
+			value = floatValue;
+		}
+		else {
+			assert(fread(&value, sizeof(double), 1, file) == 1);
+		}
+		assert(fabs(value - expectedOutputs->data[i]) < tolerance);
+	}
+	char extra;
+	assert(fread(&extra, 1, 1, file) == 0);
+	fclose(file);
+}
+
+int main() {
+	nn_Network *network = nn_Network_alloc("3, 5, 2");
+	nn_Network_randomiseWeightsBetweenMinAndMaxWithSeed(network, -2.0, 2.0, 5);
+	assert(nn_Network_writeToFile(network, "tmp.nn") == 0);
+	nn_Matrix *inputs = nn_Matrix_alloc(NUMBER_OF_ROWS, NUMBER_OF_INPUTS);
+	for (int i = 0; i < NUMBER_OF_ROWS * NUMBER_OF_INPUTS; i++) {
+		inputs->data[i] = (i % 7) / 3.0 - 1.0;
+	}
+	nn_Matrix *expectedOutputs = nn_Network_allocInference(network, inputs);
+
+	// Test nn_infer, scenario: doubles, with a smaller last batch (4, 4, 2) split across threads
+	{
+		writeInputs("tmp-inputs.bin", inputs, 0, NUMBER_OF_ROWS * NUMBER_OF_INPUTS);
+		assert(system("./nn_infer --threads 2 --batch 4 tmp.nn tmp-inputs.bin tmp-outputs.bin > /dev/null") == 0);
+		assertOutputs("tmp-outputs.bin", expectedOutputs, 0, 1e-12);
+	}
+
+	// Test nn_infer, scenario: doubles from stdin
+	{
+		writeInputs("tmp-inputs.bin", inputs, 0, NUMBER_OF_ROWS * NUMBER_OF_INPUTS);
+		assert(system("./nn_infer --threads 1 --batch 3 tmp.nn - tmp-outputs.bin < tmp-inputs.bin > /dev/null") == 0);
+		assertOutputs("tmp-outputs.bin", expectedOutputs, 0, 1e-12);
+	}
+
+	// Test nn_infer, scenario: floats, with a smaller last batch (3, 3, 3, 1)
+	{
+		// the inputs are rounded to floats on the way in, and the outputs on the way out
+		nn_Matrix *floatInputs = nn_Matrix_alloc(NUMBER_OF_ROWS, NUMBER_OF_INPUTS);
+		for (int i = 0; i < NUMBER_OF_ROWS * NUMBER_OF_INPUTS; i++) {
+			floatInputs->data[i] = (float)inputs->data[i];
+		}
+		nn_Matrix *expectedFloatOutputs = nn_Network_allocInference(network, floatInputs);
+		writeInputs("tmp-inputs.bin", inputs, 1, NUMBER_OF_ROWS * NUMBER_OF_INPUTS);
+		assert(system("./nn_infer --float --threads 2 --batch 3 tmp.nn tmp-inputs.bin tmp-outputs.bin > /dev/null") == 0);
+		assertOutputs("tmp-outputs.bin", expectedFloatOutputs, 1, 1e-6);
+		nn_Matrix_free(expectedFloatOutputs);
+		nn_Matrix_free(floatInputs);
+	}
+
+	// Test nn_infer, scenario: inputs that aren't a whole number of records
+	{
+		writeInputs("tmp-inputs.bin", inputs, 0, NUMBER_OF_ROWS * NUMBER_OF_INPUTS - 1);
+		assert(system("./nn_infer --batch 4 tmp.nn tmp-inputs.bin tmp-outputs.bin 2> /dev/null") != 0);
+	}
+
+	remove("tmp.nn");
+	remove("tmp-inputs.bin");
+	remove("tmp-outputs.bin");
+	nn_Matrix_free(expectedOutputs);
+	nn_Matrix_free(inputs);
+	nn_Network_free(network);
+	return 0;
+}